@@ -36,6 +36,15 @@ using namespace std;
 #define LIBBOARDGAME_NOINLINE
 #endif
 
+/** Hint to the CPU to load the cache line of an address.
+    Used to hide the memory latency of accesses to large tables at addresses
+    that are known some time before the access. */
+#ifdef __GNUC__
+#define LIBBOARDGAME_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define LIBBOARDGAME_PREFETCH(addr) (static_cast<void>(0))
+#endif
+
 #if defined __GNUC__ && ! defined __ICC &&  ! defined __clang__
 #define LIBBOARDGAME_FLATTEN __attribute__((flatten))
 #else
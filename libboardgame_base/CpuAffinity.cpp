@@ -0,0 +1,101 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_base/CpuAffinity.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "CpuAffinity.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifdef LIBBOARDGAME_HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+namespace libboardgame_base {
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+#ifdef LIBBOARDGAME_HAVE_LIBNUMA
+bool is_numa_available()
+{
+    static const bool is_available = (numa_available() >= 0);
+    return is_available;
+}
+#endif
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+CpuAffinitySaver::~CpuAffinitySaver()
+{
+    if (! m_cpus.empty())
+        set_thread_cpus(m_cpus);
+}
+
+//-----------------------------------------------------------------------------
+
+bool bind_thread_to_cpu(unsigned cpu)
+{
+    if (! set_thread_cpus({cpu}))
+        return false;
+#ifdef LIBBOARDGAME_HAVE_LIBNUMA
+    if (is_numa_available())
+        numa_set_localalloc();
+#endif
+    return true;
+}
+
+int get_numa_node([[maybe_unused]] unsigned cpu)
+{
+#ifdef LIBBOARDGAME_HAVE_LIBNUMA
+    if (is_numa_available())
+        return numa_node_of_cpu(static_cast<int>(cpu));
+#endif
+    return -1;
+}
+
+vector<unsigned> get_thread_cpus()
+{
+    vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return cpus;
+    for (unsigned i = 0; i < CPU_SETSIZE; ++i)
+        if (CPU_ISSET(i, &set))
+            cpus.push_back(i);
+    stable_sort(cpus.begin(), cpus.end(), [](unsigned cpu1, unsigned cpu2) {
+        return get_numa_node(cpu1) < get_numa_node(cpu2); });
+#endif
+    return cpus;
+}
+
+bool set_thread_cpus([[maybe_unused]] const vector<unsigned>& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    if (CPU_COUNT(&set) == 0)
+        return false;
+    // On Linux, pid 0 refers to the calling thread, not the whole process
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_base
@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_base/CpuAffinity.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBBOARDGAME_BASE_CPU_AFFINITY_H
+#define LIBBOARDGAME_BASE_CPU_AFFINITY_H
+
+#include <vector>
+
+namespace libboardgame_base {
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+/** Get the CPUs that the calling thread is allowed to run on.
+    If the NUMA topology is known (needs libnuma), the CPUs are ordered by
+    NUMA node, otherwise by CPU number.
+    @return The CPU numbers or an empty list if setting the CPU affinity is
+    not supported on this system. */
+vector<unsigned> get_thread_cpus();
+
+/** Restrict the calling thread to a set of CPUs.
+    @return @c false if the CPU affinity could not be set. */
+bool set_thread_cpus(const vector<unsigned>& cpus);
+
+/** Restrict the calling thread to a single CPU and allocate its memory on
+    the NUMA node of the CPU.
+    With libnuma, the memory policy of the thread is set to local allocation.
+    Without libnuma, only the CPU affinity is set and the thread relies on
+    the default first-touch policy of the operating system, which places a
+    memory page on the node of the thread that first writes to it.
+    @return @c false if the CPU affinity could not be set. */
+bool bind_thread_to_cpu(unsigned cpu);
+
+/** Get the NUMA node of a CPU.
+    @return The node or -1 if unknown. */
+int get_numa_node(unsigned cpu);
+
+//-----------------------------------------------------------------------------
+
+/** Saves the CPU affinity of the calling thread and restores it in its
+    destructor. */
+class CpuAffinitySaver
+{
+public:
+    CpuAffinitySaver() : m_cpus(get_thread_cpus()) { }
+
+    ~CpuAffinitySaver();
+
+private:
+    vector<unsigned> m_cpus;
+};
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_base
+
+#endif // LIBBOARDGAME_BASE_CPU_AFFINITY_H
@@ -36,6 +36,17 @@ inline ostream* get_log_stream()
 #endif
 }
 
+/** Set the log stream.
+    Can be used to restore the stream returned by get_log_stream() after
+    disable_logging(). Not thread-safe, no other thread may write to the log
+    while the stream is changed. */
+inline void set_log_stream([[maybe_unused]] ostream* stream)
+{
+#ifndef LIBBOARDGAME_DISABLE_LOG
+    _log_stream = stream;
+#endif
+}
+
 inline void flush_log()
 {
 #ifndef LIBBOARDGAME_DISABLE_LOG
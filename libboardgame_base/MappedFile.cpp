@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_base/MappedFile.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+#if defined __unix__ || defined __APPLE__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace libboardgame_base {
+
+//-----------------------------------------------------------------------------
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+#if defined __unix__ || defined __APPLE__
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool MappedFile::open([[maybe_unused]] const string& path)
+{
+    close();
+#if defined __unix__ || defined __APPLE__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    auto data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after closing the file descriptor
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    m_data = data;
+    m_size = size;
+    return true;
+#else
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_base
@@ -0,0 +1,56 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_base/MappedFile.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBBOARDGAME_BASE_MAPPED_FILE_H
+#define LIBBOARDGAME_BASE_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace libboardgame_base {
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+/** Read-only memory mapping of a file.
+    All processes that map the same file share the physical memory of its
+    pages. Memory mapping is currently only supported on Unix systems, on
+    other systems open() always fails. */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** Map a file.
+        Closes a previously mapped file.
+        @return @c false if the file could not be opened or mapped. */
+    bool open(const string& path);
+
+    void close();
+
+    bool is_open() const { return m_data != nullptr; }
+
+    const void* get_data() const { return m_data; }
+
+    size_t get_size() const { return m_size; }
+
+private:
+    void* m_data = nullptr;
+
+    size_t m_size = 0;
+};
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_base
+
+#endif // LIBBOARDGAME_BASE_MAPPED_FILE_H
@@ -28,6 +28,31 @@ inline T fast_exp(T x)
     return x;
 }
 
+/** Find the first element of a sorted array that is not less than a value.
+    Returns the same element as std::lower_bound() but uses no branches that
+    depend on the values. This is faster if the array is searched with
+    random values, which makes the branches in std::lower_bound()
+    unpredictable.
+    @return The index of the element or n if all elements are less than the
+    value. */
+template<typename T>
+inline unsigned lower_bound_branchless(const T* a, unsigned n, T val)
+{
+    if (n == 0)
+        return 0;
+    auto base = a;
+    while (n > 1)
+    {
+        auto half = n / 2;
+        // Multiplication instead of a conditional expression, which the
+        // compiler would compile to a branch
+        base += static_cast<unsigned>(base[half - 1] < val) * half;
+        n -= half;
+    }
+    return static_cast<unsigned>(base - a)
+            + static_cast<unsigned>(*base < val);
+}
+
 /** Modulus operation with always positive result. */
 inline int mod(int a, int b)
 {
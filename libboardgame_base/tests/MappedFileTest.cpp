@@ -0,0 +1,39 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libboardgame_base/MappedFileTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libboardgame_base/MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "libboardgame_test/Test.h"
+
+using namespace std;
+using namespace libboardgame_base;
+
+//----------------------------------------------------------------------------
+
+LIBBOARDGAME_TEST_CASE(libboardgame_base_mapped_file)
+{
+#if defined __unix__ || defined __APPLE__
+    string path = "libboardgame_base_mapped_file_test.bin";
+    {
+        ofstream out(path, ios::binary);
+        out << "abc";
+    }
+    MappedFile file;
+    LIBBOARDGAME_CHECK(file.open(path));
+    LIBBOARDGAME_CHECK(file.is_open());
+    LIBBOARDGAME_CHECK_EQUAL(file.get_size(), size_t(3));
+    LIBBOARDGAME_CHECK(memcmp(file.get_data(), "abc", 3) == 0);
+    file.close();
+    LIBBOARDGAME_CHECK(! file.is_open());
+    remove(path.c_str());
+    LIBBOARDGAME_CHECK(! file.open(path));
+#endif
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,36 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libboardgame_base/MathUtilTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libboardgame_base/MathUtil.h"
+
+#include <algorithm>
+#include "libboardgame_test/Test.h"
+
+using namespace std;
+using namespace libboardgame_base;
+
+//-----------------------------------------------------------------------------
+
+/** Compare lower_bound_branchless() with std::lower_bound() for all array
+    sizes up to 20, including arrays with equal elements. */
+LIBBOARDGAME_TEST_CASE(libboardgame_base_math_util_lower_bound_branchless)
+{
+    float a[20];
+    for (unsigned n = 0; n <= 20; ++n)
+    {
+        for (unsigned i = 0; i < n; ++i)
+            a[i] = static_cast<float>(i / 3);
+        for (float val = -1; val <= 8; val += 0.5f)
+        {
+            auto expected = static_cast<unsigned>(lower_bound(a, a + n, val)
+                                                  - a);
+            LIBBOARDGAME_CHECK_EQUAL(lower_bound_branchless(a, n, val),
+                                     expected);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
@@ -7,8 +7,9 @@
 #ifndef LIBBOARDGAME_MCTS_NODE_H
 #define LIBBOARDGAME_MCTS_NODE_H
 
+#include <cstddef>
 #include <limits>
-#include "Atomic.h"
+#include "NodeValue.h"
 #include "libboardgame_base/Assert.h"
 
 namespace libboardgame_mcts {
@@ -22,8 +23,13 @@ using NodeIdx = uint_least32_t;
 /** %Node in a MCTS tree.
     For details about how the nodes are used in lock-free multi-threaded mode,
     see M. Enzenberger, M. Mueller: A Lock-free Multithreaded Monte-Carlo Tree
-    Search Algorithm. Advances in Computer Games 2009. */
-template<typename M, typename F, bool MT>
+    Search Algorithm. Advances in Computer Games 2009.
+    @tparam M The move type.
+    @tparam F The floating type.
+    @tparam MT true, if the node is used in a multi-threaded search.
+    @tparam P true, if the value and value count should be packed into a
+    single 64-bit word that is updated atomically (see NodeValue). */
+template<typename M, typename F, bool MT, bool P = false>
 class Node
 {
 public:
@@ -113,6 +119,11 @@ public:
 
     void inc_visit_count();
 
+    /** Add to the visit count.
+        Used for merging the visit counts of nodes in different trees. The
+        argument can be negative to remove a previously added count. */
+    void add_visit_count(Float n);
+
     /** Get node index of first child.
         @pre get_nu_children() > 0. Note that in lock-free search, it can
         happen that get_nu_children() was greater 0 but becomes negative
@@ -124,15 +135,27 @@ public:
         consistent state with the children pointed to by get_first_child(). */
     NodeIdx get_first_child() const;
 
-private:
-    Atomic<Float, MT> m_value;
+    /** Offset of the value in bytes.
+        Used together with get_value_count_offset() and
+        get_move_prior_offset() for reading the members needed for selecting
+        a child directly from memory with SIMD instructions. */
+    static constexpr size_t get_value_offset();
 
-    Atomic<Float, MT> m_value_count;
+    static constexpr size_t get_value_count_offset();
 
-    Atomic<Float, MT> m_visit_count;
+    static constexpr size_t get_move_prior_offset();
+
+private:
+    // The members that are read for each child in the selection of a child
+    // are at the beginning, so that they are in the same cache line for most
+    // nodes and close to the members of the next child.
+
+    NodeValue<Float, MT, P> m_value;
 
     Float m_move_prior;
 
+    Atomic<Float, MT> m_visit_count;
+
     /** See get_nu_children() */
     Atomic<short, MT> m_nu_children;
 
@@ -141,42 +164,37 @@ private:
     Atomic<NodeIdx, MT> m_first_child;
 };
 
-template<typename M, typename F, bool MT>
-void Node<M, F, MT>::add_value(Float v, Float weight)
+template<typename M, typename F, bool MT, bool P>
+inline void Node<M, F, MT, P>::add_value(Float v, Float weight)
 {
-    // Intentionally uses no synchronization and does not care about
-    // lost updates in multi-threaded mode
-    Float count = m_value_count.load(memory_order_relaxed);
-    Float value = m_value.load(memory_order_relaxed);
-    count += weight;
-    value += weight * (v - value) / count;
-    m_value.store(value, memory_order_relaxed);
-    m_value_count.store(count, memory_order_relaxed);
+    m_value.add(v, weight);
 }
 
-template<typename M, typename F, bool MT>
-void Node<M, F, MT>::add_value_remove_loss(Float v)
+template<typename M, typename F, bool MT, bool P>
+void Node<M, F, MT, P>::add_visit_count(Float n)
 {
     // Intentionally uses no synchronization and does not care about
     // lost updates in multi-threaded mode
-    Float count = m_value_count.load(memory_order_relaxed);
-    if (count == 0)
-        return; // Adding the virtual loss was a lost update
-    Float value = m_value.load(memory_order_relaxed);
-    value += v / count;
-    m_value.store(value, memory_order_relaxed);
+    Float count = m_visit_count.load(memory_order_relaxed);
+    count += n;
+    m_visit_count.store(count, memory_order_relaxed);
+}
+
+template<typename M, typename F, bool MT, bool P>
+inline void Node<M, F, MT, P>::add_value_remove_loss(Float v)
+{
+    m_value.add_remove_loss(v);
 }
 
-template<typename M, typename F, bool MT>
-void Node<M, F, MT>::copy_data_from(const Node& node)
+template<typename M, typename F, bool MT, bool P>
+void Node<M, F, MT, P>::copy_data_from(const Node& node)
 {
     // Reminder to update this function when the class gets additional members
     struct Dummy
     {
-        Atomic<Float, MT> m_value;
-        Atomic<Float, MT> m_value_count;
-        Atomic<Float, MT> m_visit_count;
+        NodeValue<Float, MT, P> m_value;
         Float m_move_prior;
+        Atomic<Float, MT> m_visit_count;
         Atomic<short, MT> m_nu_children;
         Move m_move;
         NodeIdx m_first_child;
@@ -187,46 +205,63 @@ void Node<M, F, MT>::copy_data_from(const Node& node)
     m_move_prior = node.m_move_prior;
     // Load/store relaxed (it wouldn't even need to be atomic) because this
     // function is only used before the multi-threaded search.
-    m_value_count.store(node.m_value_count.load(memory_order_relaxed),
-                        memory_order_relaxed);
-    m_value.store(node.m_value.load(memory_order_relaxed),
-                  memory_order_relaxed);
+    m_value.copy_from(node.m_value);
     m_visit_count.store(node.m_visit_count.load(memory_order_relaxed),
                         memory_order_relaxed);
 }
 
-template<typename M, typename F, bool MT>
-inline auto Node<M, F, MT>::get_value_count() const -> Float
+template<typename M, typename F, bool MT, bool P>
+inline auto Node<M, F, MT, P>::get_value_count() const -> Float
+{
+    return m_value.get_count();
+}
+
+template<typename M, typename F, bool MT, bool P>
+constexpr size_t Node<M, F, MT, P>::get_move_prior_offset()
+{
+    return offsetof(Node, m_move_prior);
+}
+
+template<typename M, typename F, bool MT, bool P>
+constexpr size_t Node<M, F, MT, P>::get_value_count_offset()
 {
-    return m_value_count.load(memory_order_relaxed);
+    return offsetof(Node, m_value)
+            + NodeValue<Float, MT, P>::get_count_offset();
 }
 
-template<typename M, typename F, bool MT>
-inline NodeIdx Node<M, F, MT>::get_first_child() const
+template<typename M, typename F, bool MT, bool P>
+constexpr size_t Node<M, F, MT, P>::get_value_offset()
+{
+    return offsetof(Node, m_value)
+            + NodeValue<Float, MT, P>::get_value_offset();
+}
+
+template<typename M, typename F, bool MT, bool P>
+inline NodeIdx Node<M, F, MT, P>::get_first_child() const
 {
     return m_first_child.load(memory_order_acquire);
 }
 
-template<typename M, typename F, bool MT>
-inline short Node<M, F, MT>::get_nu_children() const
+template<typename M, typename F, bool MT, bool P>
+inline short Node<M, F, MT, P>::get_nu_children() const
 {
     return m_nu_children.load(memory_order_acquire);
 }
 
-template<typename M, typename F, bool MT>
-inline auto Node<M, F, MT>::get_value() const -> Float
+template<typename M, typename F, bool MT, bool P>
+inline auto Node<M, F, MT, P>::get_value() const -> Float
 {
-    return m_value.load(memory_order_relaxed);
+    return m_value.get_value();
 }
 
-template<typename M, typename F, bool MT>
-inline auto Node<M, F, MT>::get_visit_count() const -> Float
+template<typename M, typename F, bool MT, bool P>
+inline auto Node<M, F, MT, P>::get_visit_count() const -> Float
 {
     return m_visit_count.load(memory_order_relaxed);
 }
 
-template<typename M, typename F, bool MT>
-inline void Node<M, F, MT>::inc_visit_count()
+template<typename M, typename F, bool MT, bool P>
+inline void Node<M, F, MT, P>::inc_visit_count()
 {
     // We don't care about the unlikely case that updates are lost because
     // incrementing is not atomic
@@ -235,9 +270,9 @@ inline void Node<M, F, MT>::inc_visit_count()
     m_visit_count.store(count, memory_order_relaxed);
 }
 
-template<typename M, typename F, bool MT>
-void Node<M, F, MT>::init(const Move& mv, Float value, Float count,
-                          Float move_prior)
+template<typename M, typename F, bool MT, bool P>
+void Node<M, F, MT, P>::init(const Move& mv, Float value, Float count,
+                             Float move_prior)
 {
     // The node is not yet visible to other threads because init() is called
     // before the children are linked to its parent with link_children()
@@ -246,14 +281,13 @@ void Node<M, F, MT>::init(const Move& mv, Float value, Float count,
     // memory_order_relaxed.
     m_move = mv;
     m_move_prior = move_prior;
-    m_value_count.store(count, memory_order_relaxed);
-    m_value.store(value, memory_order_relaxed);
+    m_value.init(value, count);
     m_visit_count.store(0, memory_order_relaxed);
     m_nu_children.store(value_unexpanded, memory_order_relaxed);
 }
 
-template<typename M, typename F, bool MT>
-void Node<M, F, MT>::init_root()
+template<typename M, typename F, bool MT, bool P>
+void Node<M, F, MT, P>::init_root()
 {
 #ifdef LIBBOARDGAME_DEBUG
     m_move = Move::null();
@@ -262,9 +296,9 @@ void Node<M, F, MT>::init_root()
     m_nu_children.store(value_unexpanded, memory_order_relaxed);
 }
 
-template<typename M, typename F, bool MT>
-inline void Node<M, F, MT>::link_children(NodeIdx first_child,
-                                          unsigned nu_children)
+template<typename M, typename F, bool MT, bool P>
+inline void Node<M, F, MT, P>::link_children(NodeIdx first_child,
+                                             unsigned nu_children)
 {
     LIBBOARDGAME_ASSERT(nu_children < max_children);
     LIBBOARDGAME_ASSERT(nu_children < Move::range);
@@ -281,9 +315,9 @@ inline void Node<M, F, MT>::link_children(NodeIdx first_child,
     m_nu_children.store(static_cast<short>(nu_children), memory_order_release);
 }
 
-template<typename M, typename F, bool MT>
-inline void Node<M, F, MT>::link_children_st(NodeIdx first_child,
-                                             unsigned nu_children)
+template<typename M, typename F, bool MT, bool P>
+inline void Node<M, F, MT, P>::link_children_st(NodeIdx first_child,
+                                                unsigned nu_children)
 {
     LIBBOARDGAME_ASSERT(nu_children < max_children);
     LIBBOARDGAME_ASSERT(nu_children < Move::range);
@@ -294,14 +328,14 @@ inline void Node<M, F, MT>::link_children_st(NodeIdx first_child,
     m_nu_children.store(static_cast<short>(nu_children), memory_order_relaxed);
 }
 
-template<typename M, typename F, bool MT>
-void Node<M, F, MT>::set_expanding()
+template<typename M, typename F, bool MT, bool P>
+void Node<M, F, MT, P>::set_expanding()
 {
     m_nu_children.store(value_expanding, memory_order_relaxed);
 }
 
-template<typename M, typename F, bool MT>
-inline void Node<M, F, MT>::unlink_children_st()
+template<typename M, typename F, bool MT, bool P>
+inline void Node<M, F, MT, P>::unlink_children_st()
 {
     // Store relaxed (wouldn't even need to be atomic)
     m_nu_children.store(value_unexpanded, memory_order_relaxed);
@@ -0,0 +1,190 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_mcts/NodeChunkPool.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBBOARDGAME_MCTS_NODE_CHUNK_POOL_H
+#define LIBBOARDGAME_MCTS_NODE_CHUNK_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include "Node.h"
+
+namespace libboardgame_mcts {
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+/** Storage for the nodes of one or more trees.
+    The nodes are stored in chunks, which are handed out to the trees on
+    demand. The memory of a chunk is allocated when the chunk is acquired
+    for the first time and is kept for reuse after the chunk is released, so
+    several trees can share the memory limit without reserving it in
+    advance.<p>
+    Acquiring a chunk is lock-free and can be done by several threads of a
+    search simultaneously. Releasing a chunk is not thread-safe.<p>
+    A node index (NodeIdx) contains the chunk in the upper bits and the
+    position in the chunk in the lower bits, so it is valid in all trees that
+    use the same pool. Index 0 is always used by the root node of a tree,
+    because trees never release the chunk containing their root node.<p>
+    The first node of a chunk is aligned to a cache line if possible, so
+    that the positions in a chunk that are a multiple of align_nodes start a
+    cache line. */
+template<typename N>
+class NodeChunkPool
+{
+public:
+    using Node = N;
+
+    /** Number of bits of a node index used for the position in a chunk. */
+    static constexpr unsigned chunk_bits = 16;
+
+    static constexpr NodeIdx chunk_mask = (NodeIdx(1) << chunk_bits) - 1;
+
+    static constexpr size_t cache_line_size = 64;
+
+    /** Smallest number of nodes that fills a whole number of cache lines.
+        Is 1 if this number is larger than 16 because then aligning the
+        children of a node would waste too much memory. */
+    static constexpr size_t align_nodes =
+            cache_line_size / gcd(sizeof(Node), cache_line_size) <= 16 ?
+                cache_line_size / gcd(sizeof(Node), cache_line_size) : 1;
+
+
+    /** Constructor.
+        @param memory The maximum memory used by all chunks. The pool
+        contains at least two chunks, chunks are smaller than the maximum
+        size if the memory is very small. */
+    explicit NodeChunkPool(size_t memory);
+
+    /** Get a free chunk.
+        @param[out] chunk The chunk index
+        @return @c false if all chunks are in use. */
+    bool acquire(unsigned& chunk);
+
+    /** Return a chunk to the pool.
+        Must not be called while other threads acquire chunks. */
+    void release(unsigned chunk);
+
+    /** Get the first node of a chunk.
+        @pre The chunk was acquired at least once. */
+    Node* get_chunk(unsigned chunk) const { return m_chunk_nodes[chunk]; }
+
+    Node* const* get_chunk_table() const { return m_chunk_nodes.get(); }
+
+    /** The number of nodes in a chunk. */
+    size_t get_chunk_size() const { return m_chunk_size; }
+
+    unsigned get_nu_chunks() const { return m_nu_chunks; }
+
+    /** The number of chunks that are currently acquired. */
+    unsigned get_nu_used() const;
+
+    static NodeIdx get_idx(unsigned chunk, size_t pos);
+
+private:
+    size_t m_chunk_size;
+
+    unsigned m_nu_chunks;
+
+    unique_ptr<unique_ptr<Node[]>[]> m_chunks;
+
+    /** Copy of the chunk pointers for faster access. */
+    unique_ptr<Node*[]> m_chunk_nodes;
+
+    /** Stack of free chunks.
+        The elements at positions greater or equal to m_next_free are
+        free. */
+    unique_ptr<unsigned[]> m_free;
+
+    /** Position of the next free chunk in m_free.
+        Can be greater than m_nu_chunks after a failed acquire(). */
+    atomic<unsigned> m_next_free;
+};
+
+template<typename N>
+NodeChunkPool<N>::NodeChunkPool(size_t memory)
+{
+    auto max_nodes = memory / sizeof(Node);
+    // It doesn't make sense to use more nodes than what can be accessed
+    // with NodeIdx
+    max_nodes =
+        min(max_nodes, static_cast<size_t>(numeric_limits<NodeIdx>::max()));
+    m_chunk_size = max(min(max_nodes / 2, size_t(chunk_mask) + 1),
+                       size_t(1));
+    m_nu_chunks = static_cast<unsigned>(max(max_nodes / m_chunk_size,
+                                            size_t(2)));
+    m_chunks = make_unique<unique_ptr<Node[]>[]>(m_nu_chunks);
+    m_chunk_nodes = make_unique<Node*[]>(m_nu_chunks);
+    m_free = make_unique<unsigned[]>(m_nu_chunks);
+    for (unsigned i = 0; i < m_nu_chunks; ++i)
+    {
+        m_chunk_nodes[i] = nullptr;
+        m_free[i] = i;
+    }
+    m_next_free.store(0);
+}
+
+template<typename N>
+bool NodeChunkPool<N>::acquire(unsigned& chunk)
+{
+    auto i = m_next_free.fetch_add(1);
+    if (i >= m_nu_chunks)
+        return false;
+    chunk = m_free[i];
+    // No other thread can access the chunk until it is acquired, so the
+    // memory can be allocated here without locking
+    if (! m_chunks[chunk])
+    {
+        // Using make_unique<Node[]>() slows down the array creation with
+        // GCC 7/8 because the compiler does not optimize away the call to
+        // the empty Move() constructor.
+        // Allocate align_nodes - 1 additional nodes such that the chunk can
+        // start at a cache line.
+        m_chunks[chunk].reset(new Node[m_chunk_size + align_nodes - 1]);
+        auto nodes = m_chunks[chunk].get();
+        m_chunk_nodes[chunk] = nodes;
+        for (size_t i = 0; i < align_nodes; ++i)
+            if (reinterpret_cast<uintptr_t>(nodes + i) % cache_line_size == 0)
+            {
+                m_chunk_nodes[chunk] = nodes + i;
+                break;
+            }
+    }
+    return true;
+}
+
+template<typename N>
+inline NodeIdx NodeChunkPool<N>::get_idx(unsigned chunk, size_t pos)
+{
+    LIBBOARDGAME_ASSERT(pos <= chunk_mask);
+    return (static_cast<NodeIdx>(chunk) << chunk_bits)
+            | static_cast<NodeIdx>(pos);
+}
+
+template<typename N>
+unsigned NodeChunkPool<N>::get_nu_used() const
+{
+    return min(m_next_free.load(), m_nu_chunks);
+}
+
+template<typename N>
+void NodeChunkPool<N>::release(unsigned chunk)
+{
+    LIBBOARDGAME_ASSERT(chunk < m_nu_chunks);
+    auto i = get_nu_used();
+    LIBBOARDGAME_ASSERT(i > 0);
+    m_free[--i] = chunk;
+    m_next_free.store(i);
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_mcts
+
+#endif // LIBBOARDGAME_MCTS_NODE_CHUNK_POOL_H
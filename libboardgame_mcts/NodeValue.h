@@ -0,0 +1,247 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_mcts/NodeValue.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBBOARDGAME_MCTS_NODE_VALUE_H
+#define LIBBOARDGAME_MCTS_NODE_VALUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "Atomic.h"
+#include "libboardgame_base/Assert.h"
+
+namespace libboardgame_mcts {
+
+//-----------------------------------------------------------------------------
+
+/** Mean value and value count of a node.
+    @tparam F The floating type.
+    @tparam MT true, if the node is used in a multi-threaded search.
+    @tparam P true, if the value and the count should be packed into a single
+    64-bit word (see the specialization for P=true). */
+template<typename F, bool MT, bool P> class NodeValue;
+
+/** Mean value and value count stored in separate variables.
+    The updates intentionally use no synchronization and do not care about
+    lost updates in multi-threaded mode. */
+template<typename F, bool MT>
+class NodeValue<F, MT, false>
+{
+public:
+    using Float = F;
+
+    void init(Float value, Float count);
+
+    Float get_value() const { return m_value.load(memory_order_relaxed); }
+
+    Float get_count() const { return m_count.load(memory_order_relaxed); }
+
+    void add(Float v, Float weight);
+
+    void add_remove_loss(Float v);
+
+    void copy_from(const NodeValue& node_value);
+
+    /** Offset of the value in bytes. */
+    static constexpr size_t get_value_offset();
+
+    /** Offset of the count in bytes. */
+    static constexpr size_t get_count_offset();
+
+private:
+    Atomic<Float, MT> m_value;
+
+    Atomic<Float, MT> m_count;
+};
+
+template<typename F, bool MT>
+void NodeValue<F, MT, false>::add(Float v, Float weight)
+{
+    Float count = m_count.load(memory_order_relaxed);
+    Float value = m_value.load(memory_order_relaxed);
+    count += weight;
+    value += weight * (v - value) / count;
+    m_value.store(value, memory_order_relaxed);
+    m_count.store(count, memory_order_relaxed);
+}
+
+template<typename F, bool MT>
+void NodeValue<F, MT, false>::add_remove_loss(Float v)
+{
+    Float count = m_count.load(memory_order_relaxed);
+    if (count == 0)
+        return; // Adding the virtual loss was a lost update
+    Float value = m_value.load(memory_order_relaxed);
+    value += v / count;
+    m_value.store(value, memory_order_relaxed);
+}
+
+template<typename F, bool MT>
+void NodeValue<F, MT, false>::copy_from(const NodeValue& node_value)
+{
+    m_count.store(node_value.m_count.load(memory_order_relaxed),
+                  memory_order_relaxed);
+    m_value.store(node_value.m_value.load(memory_order_relaxed),
+                  memory_order_relaxed);
+}
+
+template<typename F, bool MT>
+constexpr size_t NodeValue<F, MT, false>::get_count_offset()
+{
+    return offsetof(NodeValue, m_count);
+}
+
+template<typename F, bool MT>
+constexpr size_t NodeValue<F, MT, false>::get_value_offset()
+{
+    return offsetof(NodeValue, m_value);
+}
+
+template<typename F, bool MT>
+void NodeValue<F, MT, false>::init(Float value, Float count)
+{
+    m_count.store(count, memory_order_relaxed);
+    m_value.store(value, memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+
+/** Mean value and value count packed into a single 64-bit word.
+    In multi-threaded mode, the updates use a compare-and-swap loop, so no
+    updates are lost and the value and count are always consistent with each
+    other. This is slower than the unsynchronized updates with a small number
+    of threads but avoids the systematic errors of lost updates with a large
+    number of threads.
+    The floating type must be a 32-bit type. */
+template<typename F, bool MT>
+class NodeValue<F, MT, true>
+{
+public:
+    using Float = F;
+
+    static_assert(sizeof(Float) == 4,
+                  "packed node values need a 32-bit floating type");
+
+    void init(Float value, Float count);
+
+    Float get_value() const;
+
+    Float get_count() const;
+
+    void add(Float v, Float weight);
+
+    void add_remove_loss(Float v);
+
+    void copy_from(const NodeValue& node_value);
+
+    /** Offset of the value in bytes.
+        Assumes a little-endian byte order. */
+    static constexpr size_t get_value_offset() { return 0; }
+
+    /** Offset of the count in bytes.
+        Assumes a little-endian byte order. */
+    static constexpr size_t get_count_offset() { return 4; }
+
+private:
+    /** Value in the lower 32 bits, count in the upper 32 bits. */
+    Atomic<uint64_t, MT> m_data;
+
+    static uint64_t pack(Float value, Float count);
+
+    static Float unpack_value(uint64_t data);
+
+    static Float unpack_count(uint64_t data);
+};
+
+template<typename F, bool MT>
+void NodeValue<F, MT, true>::add(Float v, Float weight)
+{
+    auto data = m_data.load(memory_order_relaxed);
+    uint64_t new_data;
+    do
+    {
+        Float count = unpack_count(data) + weight;
+        Float value = unpack_value(data);
+        value += weight * (v - value) / count;
+        new_data = pack(value, count);
+    }
+    while (! m_data.compare_exchange_weak(data, new_data,
+                                          memory_order_relaxed));
+}
+
+template<typename F, bool MT>
+void NodeValue<F, MT, true>::add_remove_loss(Float v)
+{
+    auto data = m_data.load(memory_order_relaxed);
+    uint64_t new_data;
+    do
+    {
+        Float count = unpack_count(data);
+        LIBBOARDGAME_ASSERT(count > 0);
+        new_data = pack(unpack_value(data) + v / count, count);
+    }
+    while (! m_data.compare_exchange_weak(data, new_data,
+                                          memory_order_relaxed));
+}
+
+template<typename F, bool MT>
+void NodeValue<F, MT, true>::copy_from(const NodeValue& node_value)
+{
+    m_data.store(node_value.m_data.load(memory_order_relaxed),
+                 memory_order_relaxed);
+}
+
+template<typename F, bool MT>
+inline auto NodeValue<F, MT, true>::get_count() const -> Float
+{
+    return unpack_count(m_data.load(memory_order_relaxed));
+}
+
+template<typename F, bool MT>
+inline auto NodeValue<F, MT, true>::get_value() const -> Float
+{
+    return unpack_value(m_data.load(memory_order_relaxed));
+}
+
+template<typename F, bool MT>
+void NodeValue<F, MT, true>::init(Float value, Float count)
+{
+    m_data.store(pack(value, count), memory_order_relaxed);
+}
+
+template<typename F, bool MT>
+inline uint64_t NodeValue<F, MT, true>::pack(Float value, Float count)
+{
+    uint32_t v;
+    uint32_t c;
+    memcpy(&v, &value, sizeof(v));
+    memcpy(&c, &count, sizeof(c));
+    return (static_cast<uint64_t>(c) << 32) | v;
+}
+
+template<typename F, bool MT>
+inline auto NodeValue<F, MT, true>::unpack_count(uint64_t data) -> Float
+{
+    auto c = static_cast<uint32_t>(data >> 32);
+    Float count;
+    memcpy(&count, &c, sizeof(count));
+    return count;
+}
+
+template<typename F, bool MT>
+inline auto NodeValue<F, MT, true>::unpack_value(uint64_t data) -> Float
+{
+    auto v = static_cast<uint32_t>(data);
+    Float value;
+    memcpy(&value, &v, sizeof(value));
+    return value;
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_mcts
+
+#endif // LIBBOARDGAME_MCTS_NODE_VALUE_H
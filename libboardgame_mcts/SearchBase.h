@@ -11,15 +11,19 @@
 #include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <sstream>
 #include <thread>
 #include "Atomic.h"
 #include "LastGoodReply.h"
 #include "PlayerMove.h"
+#include "SimdSelect.h"
+#include "TranspositionTable.h"
 #include "Tree.h"
 #include "TreeUtil.h"
 #include "libboardgame_base/ArrayList.h"
 #include "libboardgame_base/Barrier.h"
 #include "libboardgame_base/Compiler.h"
+#include "libboardgame_base/CpuAffinity.h"
 #include "libboardgame_base/IntervalChecker.h"
 #include "libboardgame_base/Log.h"
 #include "libboardgame_base/RandomGenerator.h"
@@ -31,10 +35,15 @@
 namespace libboardgame_mcts {
 
 using namespace std;
+using libboardgame_base::bind_thread_to_cpu;
+using libboardgame_base::get_numa_node;
+using libboardgame_base::get_thread_cpus;
+using libboardgame_base::set_thread_cpus;
 using libboardgame_base::time_to_string;
 using libboardgame_base::to_string;
 using libboardgame_base::ArrayList;
 using libboardgame_base::Barrier;
+using libboardgame_base::CpuAffinitySaver;
 using libboardgame_base::IntervalChecker;
 using libboardgame_base::RandomGenerator;
 using libboardgame_base::StatisticsBase;
@@ -95,6 +104,25 @@ struct SearchParamConstDefault
         Must be greater 0 if use_lgr is true. */
     static constexpr size_t lgr_hash_table_size = 0;
 
+    /** Share the children of nodes that correspond to the same position.
+        If enabled, the search is a graph search and the state needs to
+        provide a function get_hash() that returns a hash code for the
+        position and the player to play (or 0 if the position should not be
+        looked up).
+        @see TranspositionTable */
+    static constexpr bool use_transpositions = false;
+
+    /** See TranspositionTable::size.
+        Must be a power of two if use_transpositions is true. */
+    static constexpr size_t transposition_table_size = 0;
+
+    /** Pack the value and value count of a node into a single 64-bit word.
+        If enabled, the value and count are updated atomically with a
+        compare-and-swap loop, such that no updates are lost in a
+        multi-threaded search. Requires that Float is a 32-bit type.
+        @see NodeValue */
+    static constexpr bool pack_node_values = false;
+
     /** Use virtual loss in multi-threaded mode.
         See Chaslot et al.: Parallel Monte-Carlo Tree Search. 2008. */
     static constexpr bool virtual_loss = false;
@@ -133,6 +161,11 @@ struct SearchParamConstDefault
         the expensive function but an optimistic high value will delay aborting
         the search. */
     static constexpr double expected_sim_per_sec = 100;
+
+    /** Time interval in seconds for merging the statistics of the root
+        children if the search uses several trees.
+        @see SearchBase::set_nu_trees() */
+    static constexpr double tree_merge_interval = 0.05;
 };
 
 //-----------------------------------------------------------------------------
@@ -181,10 +214,13 @@ public:
 
     using Float = typename SearchParamConst::Float;
 
-    using Node = libboardgame_mcts::Node<M, Float, multithread>;
+    using Node = libboardgame_mcts::Node<M, Float, multithread,
+                                         SearchParamConst::pack_node_values>;
 
     using Tree = libboardgame_mcts::Tree<Node>;
 
+    using NodeChunkPool = libboardgame_mcts::NodeChunkPool<Node>;
+
     using PlayerMove = libboardgame_mcts::PlayerMove<M>;
 
 
@@ -197,10 +233,14 @@ public:
 
     static_assert(! SearchParamConst::use_lgr || lgr_hash_table_size > 0);
 
+    static constexpr size_t transposition_table_size =
+            SearchParamConst::use_transpositions ?
+                SearchParamConst::transposition_table_size : 1;
+
 
     /** Constructor.
         @param nu_threads
-        @param memory The memory to be used for (all) the search trees. */
+        @param memory The memory to be used for the search tree. */
     SearchBase(unsigned nu_threads, size_t memory);
 
     virtual ~SearchBase();
@@ -253,6 +293,15 @@ public:
 
     Float get_exploration_constant() const { return m_exploration_constant; }
 
+    /** Use SIMD instructions for selecting a child if the node has many
+        children.
+        The instruction set is detected at runtime. The selected children are
+        the same as without SIMD instructions apart from rounding errors. The
+        default value is true. */
+    void set_simd_select(bool enable);
+
+    bool get_simd_select() const { return m_simd_select != nullptr; }
+
     /** Reuse the subtree from the previous search if the current position is
         a follow-up position of the previous one.
         It will also reuse the tree if it is the same position but the last
@@ -288,6 +337,73 @@ public:
 
     Float get_rave_weight() const;
 
+    /** Number of independent trees used in a multi-threaded search.
+        The default value 1 means that all threads share a single tree
+        (tree parallelization). With a value greater than 1, the threads are
+        split into groups (thread i uses tree i modulo the number of trees)
+        and each group searches its own tree. The statistics of the root
+        children are periodically merged between the trees (root
+        parallelization with slow synchronization, see T. Cazenave,
+        N. Jouandeau: On the Parallelization of UCT. 2007). This reduces the
+        contention between threads and the systematic error of the virtual
+        loss at the cost of duplicated work in the trees. The trees share
+        the memory of the search and the additional trees are discarded after
+        the search. */
+    void set_nu_trees(unsigned n);
+
+    unsigned get_nu_trees() const { return m_nu_trees; }
+
+    /** Bind the search threads to CPUs.
+        If enabled, thread i is bound to the i-th CPU that the process may
+        run on (if libnuma is available, the CPUs are ordered by NUMA node,
+        so the threads fill one node before using the next). The threads
+        create their game-specific state after binding themselves, such that
+        the memory of the state is allocated on their local NUMA node. The
+        nodes of the tree are stored in chunks that belong to a thread (see
+        NodeChunkPool), so their memory is placed on the node of the thread
+        that first writes to it. Thread 0 runs in the thread that calls
+        search() and is bound only for the duration of the search. Changing
+        the value re-creates the threads. The default value is false. */
+    void set_pin_threads(bool enable);
+
+    bool get_pin_threads() const { return m_pin_threads; }
+
+    unsigned get_nu_threads() const { return m_nu_threads; }
+
+    /** Maximum time for extending a search with a time limit.
+        If greater than the max_time argument of search(), a search with a
+        time limit continues after max_time while the best move at the root
+        is unstable (see is_best_move_unstable()), but not longer than this
+        time. The default value 0 disables extending the search. */
+    void set_max_time_extended(double time) { m_max_time_extended = time; }
+
+    double get_max_time_extended() const { return m_max_time_extended; }
+
+    /** Confidence factor for stopping a search early.
+        If greater than zero, the search stops before its simulation or time
+        limit if the lower confidence bound of the value of the best move at
+        the root is greater than the upper confidence bound of the value of
+        the second best move. The bounds are the value minus or plus the
+        factor times the standard error of the value. This usually stops
+        much earlier than the check that the best move cannot change anymore
+        with the remaining simulations, but the search might stop with a
+        wrong best move with a probability that depends on the factor (e.g.
+        about 2% for a factor of 2 if the value estimates were independent
+        and normally distributed). The default value 0 disables the early
+        stop. */
+    void set_early_stop_confidence(Float factor)
+    {
+        m_early_stop_confidence = factor;
+    }
+
+    Float get_early_stop_confidence() const { return m_early_stop_confidence; }
+
+    /** Number of simulations that the last search saved by stopping before
+        its simulation or time limit because the best move was decided.
+        For searches with a time limit, the number is estimated from the
+        simulations per second. */
+    Float get_saved_simulations() const;
+
     /** @} */ // @name
 
 
@@ -304,6 +420,19 @@ public:
     bool search(Move& mv, Float max_count, size_t min_simulations,
                 double max_time, TimeSource& time_source);
 
+    /** Prepare the tree for a search in a follow-up position.
+        Starts extracting the subtree of the follow-up position from the tree
+        of the last search in a background thread, such that the next search
+        does not need to spend time on it. Can be called several times before
+        the next search with growing sequences (e.g. after each move of the
+        opponents). Does nothing if reuse_subtree is disabled.
+        @param sequence The move sequence leading from the root position of
+        the last search to the follow-up position (see check_followup()). */
+    void prepare_followup(const ArrayList<Move, max_moves>& sequence);
+
+    /** Get the search tree.
+        Waits for a background preparation started with prepare_followup() to
+        finish. */
     const Tree& get_tree() const;
 
 #ifdef LIBBOARDGAME_DEBUG
@@ -348,6 +477,15 @@ public:
         of simulations is reached. */
     void abort() { m_abort = true; }
 
+    /** Abort a running search and all searches started until
+        clear_stop_request() is called.
+        Unlike abort(), this cannot get lost if the search in another thread
+        has not started yet, because search() does not reset it. */
+    void request_stop() { m_stop_requested = true; m_abort = true; }
+
+    /** Clear a stop request and the abort state it caused. */
+    void clear_stop_request() { m_stop_requested = false; m_abort = false; }
+
     /** Was the last search aborted? */
     bool was_aborted() const { return m_abort; }
 
@@ -394,10 +532,16 @@ private:
 
         unsigned thread_id;
 
+        /** The tree searched by this thread in the current search. */
+        Tree* tree;
+
         /** Was the search in this thread terminated because the search tree
             was full? */
         bool is_out_of_mem;
 
+        /** Was the search in this thread extended after the maximum time? */
+        bool is_time_extended;
+
         Simulation simulation;
 
         StatisticsExt<> stat_len;
@@ -430,7 +574,10 @@ private:
 
         ~Thread();
 
-        void run();
+        /** Start the thread.
+            @param init_func Function that is run in the new thread before
+            this function returns. */
+        void run(const SearchFunc& init_func);
 
         void start_search();
 
@@ -460,7 +607,7 @@ private:
 
         thread m_thread;
 
-        void thread_main();
+        void thread_main(const SearchFunc& init_func);
     };
 
 
@@ -468,6 +615,8 @@ private:
         lock-free multi-threaded search */
     /** @{ */
 
+    NodeChunkPool m_node_pool;
+
     Tree m_tree;
 
     /** See get_root_val(). */
@@ -475,20 +624,75 @@ private:
 
     LastGoodReply<Move, max_players, lgr_hash_table_size, multithread> m_lgr;
 
+    TranspositionTable<transposition_table_size, multithread>
+    m_transposition_table;
+
     /** See get_nu_simulations(). */
     Atomic<size_t, multithread> m_nu_simulations;
 
     /** @} */ // @name
 
 
+    /** Statistics of a root child used for merging the trees. */
+    struct RootStat
+    {
+        Float value_sum;
+
+        Float value_count;
+
+        Float visit_count;
+    };
+
+    /** Information about a tree for merging the root statistics. */
+    struct MergeInfo
+    {
+        /** Index of the corresponding child of the root of m_tree for each
+            child of the root, or numeric_limits<unsigned>::max() if there is
+            none. */
+        vector<unsigned> idx;
+
+        /** Statistics that were added to each child of the root from the
+            other trees in the last merge. */
+        vector<RootStat> added;
+
+        /** The statistics of each child of the root excluding the added
+            statistics.
+            Local variable of merge_trees(), reused for efficiency. */
+        vector<RootStat> own;
+
+        /** Visit count that was added to the root in the last merge. */
+        Float root_added;
+    };
+
+
     unsigned m_nu_threads;
 
+    unsigned m_nu_trees = 1;
+
+    /** The trees used in the current search.
+        The first element is always m_tree, the other elements are from
+        m_extra_trees. */
+    vector<Tree*> m_trees;
+
+    /** Additional trees if set_nu_trees() was used.
+        They share the node pool with m_tree and are cleared at the end of a
+        search to return their memory to the pool. */
+    vector<unique_ptr<Tree>> m_extra_trees;
+
+    /** Merge information for each element of m_trees. */
+    vector<MergeInfo> m_merge_info;
+
+    /** Local variable of merge_trees(), reused for efficiency. */
+    vector<RootStat> m_merge_total;
+
     bool m_deterministic;
 
     bool m_reuse_subtree = true;
 
     bool m_reuse_tree = false;
 
+    bool m_pin_threads = false;
+
     /** Player to play at the root node of the search. */
     PlayerInt m_player;
 
@@ -501,6 +705,8 @@ private:
 
     atomic<bool> m_abort;
 
+    atomic<bool> m_stop_requested{false};
+
     Float m_rave_parent_max = 50000;
 
     Float m_rave_child_max = 2000;
@@ -520,15 +726,31 @@ private:
     /** Maximum time of current search. */
     double m_max_time;
 
+    double m_max_time_extended = 0;
+
+    Float m_early_stop_confidence = 0;
+
+    /** Simulations saved by stopping the current search early.
+        Mutable because it is set by check_abort_expensive(). */
+    mutable Atomic<Float, multithread> m_saved_simulations;
+
+    /** Visit count of the root reused from the previous search. */
+    Float m_reused_count;
+
     TimeSource* m_time_source;
 
     Float m_exploration_constant = 0;
 
+    /** Function for selecting a child with SIMD instructions or null. */
+    SimdSelectFunc m_simd_select = get_simd_select_func();
+
     Timer m_timer;
 
     vector<unique_ptr<Thread>> m_threads;
 
-    Tree m_tmp_tree;
+    /** CPU of each thread if set_pin_threads() is enabled.
+        Empty if the threads are not bound to CPUs. */
+    vector<unsigned> m_thread_cpus;
 
 #ifdef LIBBOARDGAME_DEBUG
     AssertionHandler m_assertion_handler;
@@ -539,6 +761,17 @@ private:
 
     ArrayList<Move, max_moves> m_followup_sequence;
 
+    /** Sequence from the root position of the last search that was already
+        applied to the tree by prepare_followup(). */
+    ArrayList<Move, max_moves> m_prepared_sequence;
+
+    /** Number of nodes in the tree before prepare_followup(). */
+    size_t m_prepared_old_nu_nodes;
+
+    /** Thread running the subtree extraction in prepare_followup().
+        Mutable because get_tree() must wait for it. */
+    mutable thread m_prepare_thread;
+
     bool check_abort(const ThreadState& thread_state) const;
 
     LIBBOARDGAME_NOINLINE
@@ -546,6 +779,21 @@ private:
 
     bool check_cannot_change(ThreadState& thread_state, Float remaining) const;
 
+    bool check_confidence_bounds(ThreadState& thread_state) const;
+
+    /** Check if the best move at the root is not clearly better than the
+        second best move.
+        This is the case if the child with the most wins (see select_final())
+        is not the child with the highest visit count or if it has less than
+        1.3 times the wins of the second best child. */
+    bool is_best_move_unstable() const;
+
+    /** Wait for prepare_followup() and check if the prepared tree can be
+        used for the current search.
+        @return The number of moves of m_followup_sequence that were already
+        applied to the tree. */
+    unsigned finish_prepare_followup(bool is_followup);
+
     bool estimate_reused_root_val(Tree& tree, const Node& root, Float& value,
                                   Float& count);
 
@@ -559,11 +807,23 @@ private:
     bool prune(TimeSource& time_source, double time, Float prune_min_count,
                Float& new_prune_min_count);
 
+    void init_merge_trees();
+
+    void merge_trees();
+
     void search_loop(ThreadState& thread_state);
 
+    void wait_prepare_followup() const;
+
     const Node* select_child(const Node& node,
                              const typename Tree::Children& children);
 
+    /** Check if the node layout can be used by the SIMD selection
+        functions. */
+    static constexpr bool is_simd_select_supported();
+
+    static SimdSelectLayout get_simd_select_layout();
+
     void update_lgr(ThreadState& thread_state);
 
     void update_rave(ThreadState& thread_state);
@@ -592,9 +852,9 @@ SearchBase<S, M, R>::Thread::~Thread()
 }
 
 template<class S, class M, class R>
-void SearchBase<S, M, R>::Thread::run()
+void SearchBase<S, M, R>::Thread::run(const SearchFunc& init_func)
 {
-    m_thread = thread(bind(&Thread::thread_main, this));
+    m_thread = thread(bind(&Thread::thread_main, this, cref(init_func)));
     m_thread_ready.wait();
 }
 
@@ -611,9 +871,10 @@ void SearchBase<S, M, R>::Thread::start_search()
 }
 
 template<class S, class M, class R>
-void SearchBase<S, M, R>::Thread::thread_main()
+void SearchBase<S, M, R>::Thread::thread_main(const SearchFunc& init_func)
 {
     unique_lock<mutex> lock(m_start_search_mutex);
+    init_func(thread_state);
     m_thread_ready.wait();
     while (true)
     {
@@ -660,22 +921,37 @@ void SearchBase<S, M, R>::AssertionHandler::run()
 
 template<class S, class M, class R>
 SearchBase<S, M, R>::SearchBase(unsigned nu_threads, size_t memory)
-    : m_tree(memory / 2, nu_threads),
+    : m_node_pool(memory),
+      m_tree(m_node_pool, nu_threads, m_node_pool.get_nu_chunks()),
       m_nu_threads(nu_threads),
-      m_tmp_tree(memory / 2, m_nu_threads)
+      m_trees(1, &m_tree)
 #ifdef LIBBOARDGAME_DEBUG
       , m_assertion_handler(*this)
 #endif
 { }
 
 template<class S, class M, class R>
-SearchBase<S, M, R>::~SearchBase() = default; // Non-inline to avoid GCC -Winline warning
+SearchBase<S, M, R>::~SearchBase()
+{
+    wait_prepare_followup();
+}
 
 template<class S, class M, class R>
 bool SearchBase<S, M, R>::check_abort(
         [[maybe_unused]] const ThreadState& thread_state) const
 {
-    if (m_max_count > 0 && m_tree.get_root().get_visit_count() >= m_max_count)
+    if (m_max_count == 0)
+        return false;
+    Float count;
+    if (m_trees.size() == 1)
+        count = m_tree.get_root().get_visit_count();
+    else
+        // The root of m_tree contains the counts of the other trees only up
+        // to the last merge
+        count = m_reused_count
+                + static_cast<Float>(m_nu_simulations.load(
+                                         memory_order_relaxed));
+    if (count >= m_max_count)
     {
         LIBBOARDGAME_LOG_THREAD(thread_state, "Maximum count reached");
         return true;
@@ -719,6 +995,17 @@ bool SearchBase<S, M, R>::check_abort_expensive(
         // Search uses time limit
         if (time > m_max_time)
         {
+            if (time < m_max_time_extended && is_best_move_unstable())
+            {
+                if (! thread_state.is_time_extended)
+                {
+                    thread_state.is_time_extended = true;
+                    if (thread_state.thread_id == 0)
+                        LIBBOARDGAME_LOG_THREAD(thread_state,
+                                                "Extending search time");
+                }
+                return false;
+            }
             LIBBOARDGAME_LOG_THREAD(thread_state, "Maximum time reached");
             return true;
         }
@@ -733,7 +1020,12 @@ bool SearchBase<S, M, R>::check_abort_expensive(
     }
     if (thread_state.thread_id == 0 && m_callback)
         m_callback(time, remaining_time);
-    return check_cannot_change(thread_state, remaining_simulations);
+    if (! check_cannot_change(thread_state, remaining_simulations)
+            && ! check_confidence_bounds(thread_state))
+        return false;
+    m_saved_simulations.store(max(remaining_simulations, Float(0)),
+                              memory_order_relaxed);
+    return true;
 }
 
 template<class S, class M, class R>
@@ -771,6 +1063,52 @@ bool SearchBase<S, M, R>::check_cannot_change(
     return true;
 }
 
+template<class S, class M, class R>
+bool SearchBase<S, M, R>::check_confidence_bounds(
+        [[maybe_unused]] ThreadState& thread_state) const
+{
+    if (m_early_stop_confidence <= 0)
+        return false;
+    // Don't trust the standard error of values with small counts
+    const Float min_count = 100;
+    const Node* best = nullptr;
+    const Node* second = nullptr;
+    Float max_wins = 0;
+    Float second_max = 0;
+    for (auto& i : m_tree.get_root_children())
+    {
+        Float wins = i.get_value() * i.get_value_count();
+        if (best == nullptr || wins > max_wins)
+        {
+            second = best;
+            second_max = max_wins;
+            best = &i;
+            max_wins = wins;
+        }
+        else if (second == nullptr || wins > second_max)
+        {
+            second = &i;
+            second_max = wins;
+        }
+    }
+    if (second == nullptr || best->get_value_count() < min_count
+            || second->get_value_count() < min_count)
+        return false;
+    auto get_std_err = [](const Node& node) {
+        // Avoid a zero standard error for values close to 0 or 1
+        auto value = min(max(node.get_value(), Float(0.05)), Float(0.95));
+        return sqrt(value * (1 - value) / node.get_value_count());
+    };
+    auto lower = best->get_value()
+            - m_early_stop_confidence * get_std_err(*best);
+    auto upper = second->get_value()
+            + m_early_stop_confidence * get_std_err(*second);
+    if (lower <= upper)
+        return false;
+    LIBBOARDGAME_LOG_THREAD(thread_state, "Best move is decided");
+    return true;
+}
+
 template<class S, class M, class R>
 bool SearchBase<S, M, R>::check_followup(
         [[maybe_unused]] ArrayList<Move, max_moves>& sequence)
@@ -787,21 +1125,63 @@ void SearchBase<S, M, R>::create_threads()
     LIBBOARDGAME_LOG("Creating ", m_nu_threads, " threads");
     m_threads.clear();
     m_threads.reserve(m_nu_threads);
+    m_thread_cpus.clear();
+    if (m_pin_threads)
+    {
+        auto cpus = get_thread_cpus();
+        if (cpus.empty())
+            LIBBOARDGAME_LOG("Binding threads to CPUs not supported");
+        else
+        {
+            for (unsigned i = 0; i < m_nu_threads; ++i)
+                m_thread_cpus.push_back(cpus[i % cpus.size()]);
+            if (m_nu_threads > cpus.size())
+                LIBBOARDGAME_LOG("More threads than CPUs (", cpus.size(),
+                                 ")");
+        }
+    }
     auto search_func =
         static_cast<typename Thread::SearchFunc>(
                           bind(&SearchBase::search_loop, this, placeholders::_1));
+    auto init_func =
+        static_cast<typename Thread::SearchFunc>([&](ThreadState& thread_state)
+    {
+        if (! m_thread_cpus.empty())
+        {
+            auto cpu = m_thread_cpus[thread_state.thread_id];
+            if (! bind_thread_to_cpu(cpu))
+                LIBBOARDGAME_LOG_THREAD(thread_state,
+                                        "Could not bind thread to CPU ", cpu);
+        }
+        thread_state.state = create_state();
+    });
     for (unsigned i = 0; i < m_nu_threads; ++i)
     {
         auto t = make_unique<Thread>(search_func);
         auto& thread_state = t->thread_state;
         thread_state.thread_id = i;
-        thread_state.state = create_state();
+        thread_state.tree = &m_tree;
         for (auto& was_played : thread_state.was_played)
             was_played = max_players;
         if (i > 0)
-            t->run();
+            t->run(init_func);
+        else
+            thread_state.state = create_state();
         m_threads.push_back(move(t));
     }
+    if (! m_thread_cpus.empty())
+    {
+        ostringstream s;
+        for (unsigned i = 0; i < m_nu_threads; ++i)
+        {
+            auto cpu = m_thread_cpus[i];
+            s << ' ' << cpu;
+            auto node = get_numa_node(cpu);
+            if (node >= 0)
+                s << '/' << node;
+        }
+        LIBBOARDGAME_LOG("Thread CPUs:", s.str());
+    }
 }
 
 #ifdef LIBBOARDGAME_DEBUG
@@ -824,15 +1204,43 @@ bool SearchBase<S, M, R>::expand_node(ThreadState& thread_state,
                                       const Node*& best_child)
 {
     auto& state = *thread_state.state;
+    auto& tree = *thread_state.tree;
+    uint_least64_t hash = 0;
+    // The transposition table stores node indices, which are only valid in
+    // a single tree
+    if (SearchParamConst::use_transpositions && m_trees.size() == 1)
+    {
+        hash = state.get_hash();
+        NodeIdx first_child;
+        unsigned nu_children;
+        if (hash != 0
+                && m_transposition_table.lookup(hash, first_child, nu_children))
+        {
+            tree.link_children(node, first_child, nu_children);
+            best_child = select_child(node, tree.get_children(node));
+            return true;
+        }
+    }
     auto thread_id = thread_state.thread_id;
-    typename Tree::NodeExpander expander(thread_id, m_tree,
+    typename Tree::NodeExpander expander(thread_id, tree,
                                          SearchParamConst::child_min_count,
                                          SearchParamConst::max_move_prior);
     auto root_val = m_root_val[state.get_player()].get_mean();
     if (state.gen_children(expander, root_val))
     {
-        expander.link_children(m_tree, node);
+        expander.link_children(tree, node);
         best_child = expander.get_best_child();
+        if (SearchParamConst::use_transpositions && hash != 0)
+        {
+            // Another thread might have expanded the node simultaneously but
+            // the number of children is deterministic, so any linked children
+            // are valid for this position.
+            auto nu_children = node.get_nu_children();
+            if (nu_children > 0)
+                m_transposition_table.store(
+                            hash, node.get_first_child(),
+                            static_cast<unsigned>(nu_children));
+        }
         return true;
     }
     return false;
@@ -912,9 +1320,162 @@ inline const S& SearchBase<S, M, R>::get_state(unsigned thread_id) const
 template<class S, class M, class R>
 inline auto SearchBase<S, M, R>::get_tree() const -> const Tree&
 {
+    wait_prepare_followup();
     return m_tree;
 }
 
+template<class S, class M, class R>
+unsigned SearchBase<S, M, R>::finish_prepare_followup(bool is_followup)
+{
+    wait_prepare_followup();
+    unsigned nu_prepared = m_prepared_sequence.size();
+    if (nu_prepared == 0)
+        return 0;
+    bool is_prefix = (is_followup && m_followup_sequence.size() >= nu_prepared);
+    for (unsigned i = 0; is_prefix && i < nu_prepared; ++i)
+        if (m_followup_sequence[i] != m_prepared_sequence[i])
+            is_prefix = false;
+    m_prepared_sequence.clear();
+    if (is_prefix)
+        return nu_prepared;
+    // The root of the tree no longer corresponds to the position of the last
+    // search
+    m_tree.clear();
+    return 0;
+}
+
+template<class S, class M, class R>
+void SearchBase<S, M, R>::init_merge_trees()
+{
+    auto children_0 = m_tree.get_root_children();
+    vector<unsigned> idx(Move::range, numeric_limits<unsigned>::max());
+    for (unsigned i = 0; i < children_0.size(); ++i)
+        idx[children_0.begin()[i].get_move().to_int()] = i;
+    m_merge_total.resize(children_0.size());
+    m_merge_info.resize(m_trees.size());
+    for (unsigned i = 0; i < m_trees.size(); ++i)
+    {
+        auto& info = m_merge_info[i];
+        auto children = m_trees[i]->get_root_children();
+        info.idx.clear();
+        info.added.clear();
+        info.own.resize(children.size());
+        for (auto& child : children)
+        {
+            info.idx.push_back(idx[child.get_move().to_int()]);
+            // The prior knowledge initialization of the root children is
+            // only counted in the first tree
+            if (i == 0)
+                info.added.push_back({0, 0, 0});
+            else
+                info.added.push_back({
+                    child.get_value() * child.get_value_count(),
+                    child.get_value_count(), child.get_visit_count()});
+        }
+        info.root_added = 0;
+    }
+}
+
+template<class S, class M, class R>
+bool SearchBase<S, M, R>::is_best_move_unstable() const
+{
+    const Node* best = nullptr;
+    const Node* most_visited = nullptr;
+    Float max_wins = 0;
+    Float second_max = 0;
+    for (auto& i : m_tree.get_root_children())
+    {
+        Float wins = i.get_value() * i.get_value_count();
+        if (best == nullptr || wins > max_wins)
+        {
+            second_max = max_wins;
+            max_wins = wins;
+            best = &i;
+        }
+        else if (wins > second_max)
+            second_max = wins;
+        if (most_visited == nullptr
+                || i.get_visit_count() > most_visited->get_visit_count())
+            most_visited = &i;
+    }
+    if (best != most_visited)
+        return true;
+    return max_wins < 1.3f * second_max;
+}
+
+/** Merge the statistics of the root children of the trees.
+    After the merge, the root children of each tree contain the sum of the
+    statistics of all trees. To avoid counting the statistics of a tree
+    multiple times, each tree remembers what was added from the other trees in
+    the last merge. Other threads may update the nodes during the merge, which
+    can cause lost updates like in the lock-free search. */
+template<class S, class M, class R>
+void SearchBase<S, M, R>::merge_trees()
+{
+    for (auto& total : m_merge_total)
+        total = {0, 0, 0};
+    Float root_total = 0;
+    for (unsigned i = 0; i < m_trees.size(); ++i)
+    {
+        auto& tree = *m_trees[i];
+        auto& info = m_merge_info[i];
+        auto children = tree.get_root_children().begin();
+        for (unsigned j = 0; j < info.idx.size(); ++j)
+        {
+            auto idx = info.idx[j];
+            if (idx == numeric_limits<unsigned>::max())
+                continue;
+            auto& child = children[j];
+            auto& added = info.added[j];
+            auto& own = info.own[j];
+            auto value_count = child.get_value_count();
+            own.value_sum =
+                    child.get_value() * value_count - added.value_sum;
+            own.value_count = value_count - added.value_count;
+            own.visit_count = child.get_visit_count() - added.visit_count;
+            auto& total = m_merge_total[idx];
+            total.value_sum += own.value_sum;
+            total.value_count += own.value_count;
+            total.visit_count += own.visit_count;
+        }
+        root_total += tree.get_root().get_visit_count() - info.root_added;
+    }
+    for (unsigned i = 0; i < m_trees.size(); ++i)
+    {
+        auto& tree = *m_trees[i];
+        auto& info = m_merge_info[i];
+        auto children = tree.get_root_children().begin();
+        for (unsigned j = 0; j < info.idx.size(); ++j)
+        {
+            auto idx = info.idx[j];
+            if (idx == numeric_limits<unsigned>::max())
+                continue;
+            auto& child = children[j];
+            auto& added = info.added[j];
+            auto& own = info.own[j];
+            auto& total = m_merge_total[idx];
+            auto value_sum = total.value_sum - own.value_sum;
+            auto value_count = total.value_count - own.value_count;
+            auto visit_count = total.visit_count - own.visit_count;
+            auto weight = value_count - added.value_count;
+            if (weight != 0 && child.get_value_count() + weight > 0)
+            {
+                tree.add_value(child, (value_sum - added.value_sum) / weight,
+                               weight);
+                added.value_sum = value_sum;
+                added.value_count = value_count;
+            }
+            tree.add_visit_count(child, visit_count - added.visit_count);
+            added.visit_count = visit_count;
+        }
+        auto& root = tree.get_root();
+        auto root_added =
+                root_total - (root.get_visit_count() - info.root_added);
+        tree.add_visit_count(root, root_added - info.root_added);
+        info.root_added = root_added;
+    }
+}
+
 template<class S, class M, class R>
 void SearchBase<S, M, R>::on_start_search([[maybe_unused]] bool is_followup)
 {
@@ -926,19 +1487,9 @@ void SearchBase<S, M, R>::playout(ThreadState& thread_state)
 {
     auto& state = *thread_state.state;
     state.start_playout();
-    auto& simulation = thread_state.simulation;
-    auto& moves = simulation.moves;
-    auto nu_moves = moves.size();
-    Move last = nu_moves > 0 ? moves[nu_moves - 1].move : Move::null();
-    Move second_last = nu_moves > 1 ? moves[nu_moves - 2].move : Move::null();
-    PlayerMove mv;
-    while (state.gen_playout_move(m_lgr, last, second_last, mv))
-    {
-        state.play_playout(mv.move);
-        moves.push_back(mv);
-        second_last = last;
-        last = mv.move;
-    }
+    // The state runs the loop over the playout moves, which allows it to
+    // dispatch on game-dependent parameters only once per playout
+    state.playout(m_lgr, thread_state.simulation.moves);
 }
 
 template<class S, class M, class R>
@@ -948,15 +1499,16 @@ void SearchBase<S, M, R>::play_in_tree(ThreadState& thread_state)
     auto& simulation = thread_state.simulation;
     simulation.nodes.resize(1);
     simulation.moves.clear();
-    auto& root = m_tree.get_root();
+    auto& tree = *thread_state.tree;
+    auto& root = tree.get_root();
     auto node = &root;
     Float expansion_threshold = SearchParamConst::expansion_threshold;
     typename Tree::Children children;
-    while (! (children = m_tree.get_children(*node)).empty())
+    while (! (children = tree.get_children(*node)).empty())
     {
         node = select_child(*node, children);
         if (multithread && SearchParamConst::virtual_loss)
-            m_tree.add_value(*node, 0);
+            tree.add_value(*node, 0);
         simulation.nodes.push_back(node);
         Move mv = node->get_move();
         simulation.moves.push_back({state.get_player(), mv});
@@ -966,7 +1518,7 @@ void SearchBase<S, M, R>::play_in_tree(ThreadState& thread_state)
     state.finish_in_tree();
     if (node->get_visit_count() > expansion_threshold && node->is_unexpanded())
     {
-        m_tree.set_expanding(*node);
+        tree.set_expanding(*node);
         if (! expand_node(thread_state, *node, node))
             thread_state.is_out_of_mem = true;
         else if (node)
@@ -992,6 +1544,8 @@ string SearchBase<S, M, R>::get_info() const
       << setprecision(0) << ", ValCnt " << get_root_val().get_count()
       << ", Vst " << get_root_visit_count()
       << ", Sim " << m_nu_simulations;
+    if (get_saved_simulations() > 0)
+        s << ", Saved " << get_saved_simulations();
     auto child = select_final();
     if (child && root.get_visit_count() > 0)
         s << setprecision(1) << ", Chld "
@@ -1013,20 +1567,64 @@ string SearchBase<S, M, R>::get_info_ext() const
     return {};
 }
 
+template<class S, class M, class R>
+inline auto SearchBase<S, M, R>::get_saved_simulations() const -> Float
+{
+    return m_saved_simulations.load(memory_order_relaxed);
+}
+
+template<class S, class M, class R>
+void SearchBase<S, M, R>::prepare_followup(
+        const ArrayList<Move, max_moves>& sequence)
+{
+    wait_prepare_followup();
+    if (! m_reuse_subtree)
+        return;
+    unsigned nu_prepared = m_prepared_sequence.size();
+    if (nu_prepared == 0)
+        m_prepared_old_nu_nodes = m_tree.get_nu_nodes();
+    bool is_prefix = (sequence.size() >= nu_prepared);
+    for (unsigned i = 0; is_prefix && i < nu_prepared; ++i)
+        if (sequence[i] != m_prepared_sequence[i])
+            is_prefix = false;
+    m_prepared_sequence = sequence;
+    if (! is_prefix)
+    {
+        m_tree.clear();
+        return;
+    }
+    if (nu_prepared == sequence.size())
+        return;
+    m_prepare_thread = thread([this, nu_prepared] {
+        auto node = &m_tree.get_root();
+        for (auto i = nu_prepared; node && i < m_prepared_sequence.size(); ++i)
+            node = find_child(m_tree, *node, m_prepared_sequence[i]);
+        if (node)
+            m_tree.extract_subtree(*node);
+        else
+            m_tree.clear();
+    });
+}
+
 template<class S, class M, class R>
 bool SearchBase<S, M, R>::prune(
         TimeSource& time_source, [[maybe_unused]] double time,
         Float prune_min_count, Float& new_prune_min_count)
 {
     Timer timer(time_source);
-    m_tmp_tree.clear();
-    m_tree.copy_subtree(m_tmp_tree, m_tmp_tree.get_root(), m_tree.get_root(),
-                        prune_min_count);
-    auto percent = int(m_tmp_tree.get_nu_nodes() * 100 / m_tree.get_nu_nodes());
+    size_t old_nu_nodes = 0;
+    size_t nu_nodes = 0;
+    for (auto tree : m_trees)
+    {
+        old_nu_nodes += tree->get_nu_nodes();
+        tree->compact(prune_min_count);
+        nu_nodes += tree->get_nu_nodes();
+    }
+    auto percent = int(nu_nodes * 100 / old_nu_nodes);
     LIBBOARDGAME_LOG("Pruning MinCnt: ", prune_min_count, ", AtTm: ", time,
-                     ", Nds: ", m_tmp_tree.get_nu_nodes(), " (", percent,
-                     "%), Tm: ", timer());
-    m_tree.swap(m_tmp_tree);
+                     ", Nds: ", nu_nodes, " (", percent, "%), Tm: ", timer());
+    if (SearchParamConst::use_transpositions)
+        m_transposition_table.clear();
     if (percent > 50)
     {
         if (prune_min_count >= 0.5f * numeric_limits<Float>::max())
@@ -1069,8 +1667,15 @@ bool SearchBase<S, M, R>::search(Move& mv, Float max_count,
 {
     if (m_nu_threads != m_threads.size())
         create_threads();
+    unique_ptr<CpuAffinitySaver> affinity_saver;
+    if (! m_thread_cpus.empty())
+    {
+        affinity_saver = make_unique<CpuAffinitySaver>();
+        set_thread_cpus({m_thread_cpus[0]});
+    }
     m_deterministic = RandomGenerator::has_global_seed();
     bool is_followup = check_followup(m_followup_sequence);
+    auto nu_prepared = finish_prepare_followup(is_followup);
     on_start_search(is_followup);
     if (max_count > 0)
         // A fixed number of simulations means that no time limit is used, but
@@ -1096,7 +1701,7 @@ bool SearchBase<S, M, R>::search(Move& mv, Float max_count,
     else
         for (PlayerInt i = 0; i < m_nu_players; ++i)
             m_root_val[i].init(SearchParamConst::tie_value, 1);
-    if ((m_reuse_subtree && (is_followup || m_abort))
+    if ((m_reuse_subtree && (is_followup || (m_abort && is_same)))
             || (m_reuse_tree && is_same))
     {
         size_t tree_nodes = m_tree.get_nu_nodes();
@@ -1109,29 +1714,32 @@ bool SearchBase<S, M, R>::search(Move& mv, Float max_count,
         else
         {
             Timer timer(time_source);
-            m_tmp_tree.clear();
-            auto node = find_node(m_tree, m_followup_sequence);
+            if (nu_prepared > 0)
+                tree_nodes = m_prepared_old_nu_nodes;
+            auto node = &m_tree.get_root();
+            for (auto i = nu_prepared; node && i < m_followup_sequence.size();
+                 ++i)
+                node = find_child(m_tree, *node, m_followup_sequence[i]);
             if (node)
             {
-                m_tree.extract_subtree(m_tmp_tree, *node);
-                auto& tmp_tree_root = m_tmp_tree.get_root();
+                if (node != &m_tree.get_root())
+                    m_tree.extract_subtree(*node);
+                auto& root = m_tree.get_root();
                 if (! is_same)
                 {
                     Float value, count;
-                    if (estimate_reused_root_val(m_tmp_tree, tmp_tree_root,
-                                                 value, count))
+                    if (estimate_reused_root_val(m_tree, root, value, count))
                         m_root_val[m_player].add(value, count);
                 }
-                size_t tmp_tree_nodes = m_tmp_tree.get_nu_nodes();
-                if (tree_nodes > 1 && tmp_tree_nodes > 1)
+                size_t new_tree_nodes = m_tree.get_nu_nodes();
+                if (tree_nodes > 1 && new_tree_nodes > 1)
                 {
                     double time = timer();
-                    LIBBOARDGAME_LOG("Reusing ", tmp_tree_nodes, " nodes (",
+                    LIBBOARDGAME_LOG("Reusing ", new_tree_nodes, " nodes (",
                                      std::fixed, setprecision(1),
-                                     100 * double(tmp_tree_nodes)
+                                     100 * double(new_tree_nodes)
                                      / double(tree_nodes),
                                      "% tm=", setprecision(4), time, ")");
-                    m_tree.swap(m_tmp_tree);
                     clear_tree = false;
                     max_time -= time;
                     if (max_time < 0)
@@ -1142,10 +1750,12 @@ bool SearchBase<S, M, R>::search(Move& mv, Float max_count,
     }
     if (clear_tree)
         m_tree.clear();
+    if (SearchParamConst::use_transpositions)
+        m_transposition_table.clear();
 
     m_timer.reset(time_source);
     m_time_source = &time_source;
-    m_abort = false;
+    m_abort = m_stop_requested.load();
     if (SearchParamConst::use_lgr && ! is_followup)
         m_lgr.init(m_nu_players);
     for (auto& i : m_threads)
@@ -1153,21 +1763,23 @@ bool SearchBase<S, M, R>::search(Move& mv, Float max_count,
         auto& thread_state = i->thread_state;
         thread_state.stat_len.clear();
         thread_state.stat_in_tree_len.clear();
+        thread_state.is_time_extended = false;
         thread_state.state->start_search();
     }
     m_max_count = max_count;
     m_min_simulations = min_simulations;
     m_max_time = max_time;
     m_nu_simulations.store(0);
+    m_saved_simulations.store(0, memory_order_relaxed);
     Float prune_min_count = SearchParamConst::prune_count_start;
 
     // Don't use multi-threading for very short searches (less than 0.5s).
-    auto reused_count = m_tree.get_root().get_visit_count();
+    m_reused_count = m_tree.get_root().get_visit_count();
     unsigned nu_threads = m_nu_threads;
     double expected_time;
     if (max_count > 0)
         expected_time =
-                (max_count - reused_count)
+                (max_count - m_reused_count)
                 / SearchParamConst::expected_sim_per_sec;
     else
         expected_time = max_time;
@@ -1177,15 +1789,37 @@ bool SearchBase<S, M, R>::search(Move& mv, Float max_count,
         nu_threads = 1;
     }
 
+    auto nu_trees = min(m_nu_trees, nu_threads);
+    m_trees.resize(1);
+    for (unsigned i = 1; i < nu_trees; ++i)
+    {
+        if (m_extra_trees.size() < i)
+            m_extra_trees.push_back(
+                        make_unique<Tree>(m_node_pool, m_nu_threads,
+                                          m_node_pool.get_nu_chunks()));
+        m_trees.push_back(m_extra_trees[i - 1].get());
+    }
+    if (nu_trees > 1)
+        LIBBOARDGAME_LOG("Using ", nu_trees, " trees");
+    for (unsigned i = 0; i < m_nu_threads; ++i)
+        m_threads[i]->thread_state.tree = m_trees[i % nu_trees];
+
     auto& thread_state_0 = m_threads[0]->thread_state;
-    auto& root = m_tree.get_root();
-    if (root.get_nu_children() <= 0)
+    for (auto tree : m_trees)
     {
+        auto& root = tree->get_root();
+        if (root.get_nu_children() > 0)
+            continue;
         const Node* best_child;
+        thread_state_0.tree = tree;
         thread_state_0.state->start_simulation(0);
         thread_state_0.state->finish_in_tree();
         expand_node(thread_state_0, root, best_child);
     }
+    thread_state_0.tree = &m_tree;
+    if (nu_trees > 1)
+        init_merge_trees();
+    auto& root = m_tree.get_root();
 
     auto nu_children = root.get_nu_children();
     if (nu_children <= 0)
@@ -1212,6 +1846,13 @@ bool SearchBase<S, M, R>::search(Move& mv, Float max_count,
             double time = m_timer();
             prune(time_source, time, prune_min_count, prune_min_count);
         }
+    if (nu_trees > 1)
+    {
+        merge_trees();
+        for (unsigned i = 1; i < nu_trees; ++i)
+            m_trees[i]->clear();
+        m_trees.resize(1);
+    }
 
     m_last_time = m_timer();
     LIBBOARDGAME_LOG(get_info());
@@ -1225,7 +1866,7 @@ void SearchBase<S, M, R>::search_loop(ThreadState& thread_state)
 {
     auto& state = *thread_state.state;
     auto& simulation = thread_state.simulation;
-    simulation.nodes.assign(&m_tree.get_root());
+    simulation.nodes.assign(&thread_state.tree->get_root());
     simulation.moves.clear();
     double time_interval = 0.1;
     if (m_max_count == 0 && m_max_time < 1)
@@ -1241,12 +1882,21 @@ void SearchBase<S, M, R>::search_loop(ThreadState& thread_state)
                     max(1.0, SearchParamConst::expected_sim_per_sec / 5.0));
         expensive_abort_checker.set_deterministic(interval);
     }
+    bool is_merging = (thread_state.thread_id == 0 && m_trees.size() > 1);
+    IntervalChecker merge_checker(*m_time_source,
+                                  SearchParamConst::tree_merge_interval,
+                                  [this] {
+                                      merge_trees();
+                                      return false;
+                                  });
     while (true)
     {
         thread_state.is_out_of_mem = false;
         if ((check_abort(thread_state) || expensive_abort_checker())
                 && m_nu_simulations >= m_min_simulations)
             break;
+        if (is_merging)
+            merge_checker();
         state.start_simulation(m_nu_simulations.fetch_add(1));
         play_in_tree(thread_state);
         if (thread_state.is_out_of_mem)
@@ -1284,6 +1934,16 @@ inline auto SearchBase<S, M, R>::select_child(
             expl_factor * SearchParamConst::max_move_prior
             / SearchParamConst::child_min_count;
     auto i = children.begin();
+    if constexpr (is_simd_select_supported())
+        // The scalar loop below is faster for a small number of children
+        // because it can skip the division for most children
+        if (children.size() >= 16 && m_simd_select != nullptr)
+        {
+            static const auto layout = get_simd_select_layout();
+            return i + m_simd_select(
+                        reinterpret_cast<const float*>(i), layout,
+                        static_cast<unsigned>(children.size()), expl_factor);
+        }
     auto value =
             i->get_value()
             + i->get_move_prior() * expl_factor / i->get_value_count();
@@ -1306,6 +1966,45 @@ inline auto SearchBase<S, M, R>::select_child(
     return best_child;
 }
 
+template<class S, class M, class R>
+constexpr bool SearchBase<S, M, R>::is_simd_select_supported()
+{
+#ifdef LIBBOARDGAME_MCTS_SIMD_SELECT
+    if constexpr (is_same_v<Float, float> && is_standard_layout_v<Node>)
+    {
+        // The SIMD functions read the value and count of the children,
+        // which are atomic in multi-threaded mode, through a float pointer.
+        // This is not allowed by the C++ standard but works with GCC and
+        // Clang on x86-64 (the only platform with SIMD selection) if the
+        // atomics are lock-free and have the size and alignment of the
+        // underlying type. Like the relaxed loads of the scalar loop, the
+        // read values may be outdated.
+        static_assert(! multithread || atomic<float>::is_always_lock_free);
+        static_assert(sizeof(Atomic<float, multithread>) == sizeof(float));
+        static_assert(alignof(Atomic<float, multithread>) == alignof(float));
+        static_assert(! multithread || atomic<uint64_t>::is_always_lock_free);
+        static_assert(sizeof(Atomic<uint64_t, multithread>)
+                      == sizeof(uint64_t));
+        static_assert(alignof(Atomic<uint64_t, multithread>)
+                      == alignof(uint64_t));
+        return sizeof(Node) % sizeof(float) == 0
+                && Node::get_value_offset() % sizeof(float) == 0
+                && Node::get_value_count_offset() % sizeof(float) == 0
+                && Node::get_move_prior_offset() % sizeof(float) == 0;
+    }
+#endif
+    return false;
+}
+
+template<class S, class M, class R>
+SimdSelectLayout SearchBase<S, M, R>::get_simd_select_layout()
+{
+    return {sizeof(Node) / sizeof(float),
+            Node::get_value_offset() / sizeof(float),
+            Node::get_value_count_offset() / sizeof(float),
+            Node::get_move_prior_offset() / sizeof(float)};
+}
+
 template<class S, class M, class R>
 auto SearchBase<S, M, R>::select_final() const-> const Node*
 {
@@ -1347,6 +2046,31 @@ void SearchBase<S, M, R>::set_callback(
     m_callback = callback;
 }
 
+template<class S, class M, class R>
+void SearchBase<S, M, R>::set_nu_trees(unsigned n)
+{
+    LIBBOARDGAME_ASSERT(n > 0);
+    if (! multithread && n > 1)
+        throw runtime_error("libboardgame_mcts::Search was compiled"
+                            " without support for multithreading");
+    m_nu_trees = n;
+    // Releasing the memory of unused trees is not thread-safe with a running
+    // prepare_followup()
+    wait_prepare_followup();
+    if (m_extra_trees.size() > n - 1)
+        m_extra_trees.resize(n - 1);
+}
+
+template<class S, class M, class R>
+void SearchBase<S, M, R>::set_pin_threads(bool enable)
+{
+    if (enable == m_pin_threads)
+        return;
+    m_pin_threads = enable;
+    if (! m_threads.empty())
+        create_threads();
+}
+
 template<class S, class M, class R>
 void SearchBase<S, M, R>::set_rave_parent_max(Float n)
 {
@@ -1371,6 +2095,12 @@ void SearchBase<S, M, R>::set_reuse_subtree(bool enable)
     m_reuse_subtree = enable;
 }
 
+template<class S, class M, class R>
+void SearchBase<S, M, R>::set_simd_select(bool enable)
+{
+    m_simd_select = (enable ? get_simd_select_func() : nullptr);
+}
+
 template<class S, class M, class R>
 void SearchBase<S, M, R>::set_reuse_tree(bool enable)
 {
@@ -1415,6 +2145,7 @@ template<class S, class M, class R>
 void SearchBase<S, M, R>::update_rave(ThreadState& thread_state)
 {
     const auto& state = *thread_state.state;
+    auto& tree = *thread_state.tree;
     auto& moves = thread_state.simulation.moves;
     auto nu_moves = static_cast<unsigned>(moves.size());
     if (nu_moves == 0)
@@ -1449,7 +2180,7 @@ void SearchBase<S, M, R>::update_rave(ThreadState& thread_state)
         Float dist_factor;
         if (SearchParamConst::rave_dist_weighting)
             dist_factor = 1 / static_cast<Float>(nu_moves - i);
-        for (auto& it : m_tree.get_children(*node))
+        for (auto& it : tree.get_children(*node))
         {
             auto mv = it.get_move();
             if (was_played[mv.to_int()] != player
@@ -1460,7 +2191,7 @@ void SearchBase<S, M, R>::update_rave(ThreadState& thread_state)
             Float weight = m_rave_weight;
             if (SearchParamConst::rave_dist_weighting)
                 weight *= 1 - static_cast<Float>(first - i) * dist_factor;
-            m_tree.add_value(it, thread_state.simulation.eval[player], weight);
+            tree.add_value(it, thread_state.simulation.eval[player], weight);
         }
         if (i == 0)
             break;
@@ -1484,7 +2215,8 @@ void SearchBase<S, M, R>::update_values(ThreadState& thread_state)
     auto& nodes = simulation.nodes;
     auto& eval = simulation.eval;
     auto nu_nodes = static_cast<unsigned>(nodes.size());
-    m_tree.inc_visit_count(*nodes[0]);
+    auto& tree = *thread_state.tree;
+    tree.inc_visit_count(*nodes[0]);
     for (unsigned i = 1; i < nu_nodes; ++i)
     {
         auto& node = *nodes[i];
@@ -1497,15 +2229,22 @@ void SearchBase<S, M, R>::update_values(ThreadState& thread_state)
             // lost because the removal is done in this function with many
             // calls to add_value() but the adding is done in play_in_tree().
             // This could introduce a systematic error.
-            m_tree.add_value_remove_loss(node, eval[mv.player]);
+            tree.add_value_remove_loss(node, eval[mv.player]);
         else
-            m_tree.add_value(node, eval[mv.player]);
-        m_tree.inc_visit_count(node);
+            tree.add_value(node, eval[mv.player]);
+        tree.inc_visit_count(node);
     }
     for (PlayerInt i = 0; i < m_nu_players; ++i)
         m_root_val[i].add(eval[i]);
 }
 
+template<class S, class M, class R>
+void SearchBase<S, M, R>::wait_prepare_followup() const
+{
+    if (m_prepare_thread.joinable())
+        m_prepare_thread.join();
+}
+
 //-----------------------------------------------------------------------------
 
 } // namespace libboardgame_mcts
@@ -0,0 +1,235 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_mcts/SimdSelect.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBBOARDGAME_MCTS_SIMD_SELECT_H
+#define LIBBOARDGAME_MCTS_SIMD_SELECT_H
+
+#include <cstddef>
+#include <limits>
+
+#if defined(__GNUC__) && defined(__x86_64__) \
+    && ! defined(LIBBOARDGAME_MCTS_NO_SIMD)
+#define LIBBOARDGAME_MCTS_SIMD_SELECT
+#include <immintrin.h>
+#endif
+
+namespace libboardgame_mcts {
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+/** Layout of the children data used by the SIMD selection functions.
+    All members are in units of float. */
+struct SimdSelectLayout
+{
+    /** Distance between the data of two successive children. */
+    size_t stride;
+
+    /** Offset of the value. */
+    size_t value;
+
+    /** Offset of the value count. */
+    size_t count;
+
+    /** Offset of the move prior. */
+    size_t prior;
+};
+
+/** Function that returns the index of the child with the highest
+    value + prior * expl_factor / count.
+    If several children have the highest value, the first one is returned
+    like in the scalar selection loop in SearchBase::select_child(). The
+    result can still differ from the scalar loop if values differ only by
+    rounding errors because the compiler may reorder floating-point
+    operations in the scalar loop (the code is compiled with -ffast-math).
+    @param data The data of the first child. The values may be stored in
+    atomic variables, which are read as plain floats (see the assumptions
+    checked in SearchBase::is_simd_select_supported()).
+    @param layout
+    @param nu_children
+    @param expl_factor */
+using SimdSelectFunc = unsigned (*)(const float* data,
+                                    const SimdSelectLayout& layout,
+                                    unsigned nu_children, float expl_factor);
+
+/** Get the selection value of a single child. */
+inline float get_simd_select_value(const float* p,
+                                   const SimdSelectLayout& layout,
+                                   float expl_factor)
+{
+    return p[layout.value] + p[layout.prior] * expl_factor / p[layout.count];
+}
+
+/** Scalar version of the selection functions.
+    Used for testing the SIMD versions. */
+inline unsigned simd_select_scalar(const float* data,
+                                   const SimdSelectLayout& layout,
+                                   unsigned nu_children, float expl_factor)
+{
+    unsigned best = 0;
+    auto best_value = -numeric_limits<float>::max();
+    for (unsigned i = 0; i < nu_children; ++i)
+    {
+        auto value = get_simd_select_value(data + i * layout.stride, layout,
+                                           expl_factor);
+        if (value > best_value)
+        {
+            best_value = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+#ifdef LIBBOARDGAME_MCTS_SIMD_SELECT
+
+/** SSE2 version of the selection functions.
+    SSE2 is always available on x86-64. */
+inline unsigned simd_select_sse2(const float* data,
+                                 const SimdSelectLayout& layout,
+                                 unsigned nu_children, float expl_factor)
+{
+    auto stride = layout.stride;
+    auto expl = _mm_set1_ps(expl_factor);
+    auto best_value = _mm_set1_ps(-numeric_limits<float>::max());
+    auto best_idx = _mm_setzero_si128();
+    auto idx = _mm_set_epi32(3, 2, 1, 0);
+    auto four = _mm_set1_epi32(4);
+    unsigned i = 0;
+    for ( ; i + 4 <= nu_children; i += 4)
+    {
+        auto p0 = data + i * stride;
+        auto p1 = p0 + stride;
+        auto p2 = p1 + stride;
+        auto p3 = p2 + stride;
+        auto value = _mm_set_ps(p3[layout.value], p2[layout.value],
+                                p1[layout.value], p0[layout.value]);
+        auto count = _mm_set_ps(p3[layout.count], p2[layout.count],
+                                p1[layout.count], p0[layout.count]);
+        auto prior = _mm_set_ps(p3[layout.prior], p2[layout.prior],
+                                p1[layout.prior], p0[layout.prior]);
+        value = _mm_add_ps(value,
+                           _mm_div_ps(_mm_mul_ps(prior, expl), count));
+        auto is_better = _mm_cmpgt_ps(value, best_value);
+        auto is_better_i = _mm_castps_si128(is_better);
+        best_value = _mm_or_ps(_mm_and_ps(is_better, value),
+                               _mm_andnot_ps(is_better, best_value));
+        best_idx = _mm_or_si128(_mm_and_si128(is_better_i, idx),
+                                _mm_andnot_si128(is_better_i, best_idx));
+        idx = _mm_add_epi32(idx, four);
+    }
+    alignas(16) float values[4];
+    alignas(16) unsigned indices[4];
+    _mm_store_ps(values, best_value);
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), best_idx);
+    unsigned best = 0;
+    float max_value = -numeric_limits<float>::max();
+    for (unsigned j = 0; j < 4; ++j)
+        if (values[j] > max_value
+                || (values[j] == max_value && indices[j] < best))
+        {
+            max_value = values[j];
+            best = indices[j];
+        }
+    for ( ; i < nu_children; ++i)
+    {
+        auto value = get_simd_select_value(data + i * stride, layout,
+                                           expl_factor);
+        if (value > max_value)
+        {
+            max_value = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/** AVX2 version of the selection functions.
+    Uses gather instructions for reading the data of 8 children. */
+__attribute__((target("avx2")))
+inline unsigned simd_select_avx2(const float* data,
+                                 const SimdSelectLayout& layout,
+                                 unsigned nu_children, float expl_factor)
+{
+    auto stride = static_cast<int>(layout.stride);
+    auto offsets = _mm256_set_epi32(7 * stride, 6 * stride, 5 * stride,
+                                    4 * stride, 3 * stride, 2 * stride,
+                                    stride, 0);
+    auto value_idx = _mm256_add_epi32(
+                offsets, _mm256_set1_epi32(static_cast<int>(layout.value)));
+    auto count_idx = _mm256_add_epi32(
+                offsets, _mm256_set1_epi32(static_cast<int>(layout.count)));
+    auto prior_idx = _mm256_add_epi32(
+                offsets, _mm256_set1_epi32(static_cast<int>(layout.prior)));
+    auto expl = _mm256_set1_ps(expl_factor);
+    auto best_value = _mm256_set1_ps(-numeric_limits<float>::max());
+    auto best_idx = _mm256_setzero_si256();
+    auto idx = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    auto eight = _mm256_set1_epi32(8);
+    unsigned i = 0;
+    for ( ; i + 8 <= nu_children; i += 8)
+    {
+        auto p = data + i * layout.stride;
+        auto value = _mm256_i32gather_ps(p, value_idx, 4);
+        auto count = _mm256_i32gather_ps(p, count_idx, 4);
+        auto prior = _mm256_i32gather_ps(p, prior_idx, 4);
+        value = _mm256_add_ps(
+                    value, _mm256_div_ps(_mm256_mul_ps(prior, expl), count));
+        auto is_better = _mm256_cmp_ps(value, best_value, _CMP_GT_OQ);
+        best_value = _mm256_blendv_ps(best_value, value, is_better);
+        best_idx = _mm256_blendv_epi8(best_idx, idx,
+                                      _mm256_castps_si256(is_better));
+        idx = _mm256_add_epi32(idx, eight);
+    }
+    alignas(32) float values[8];
+    alignas(32) unsigned indices[8];
+    _mm256_store_ps(values, best_value);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indices), best_idx);
+    unsigned best = 0;
+    float max_value = -numeric_limits<float>::max();
+    for (unsigned j = 0; j < 8; ++j)
+        if (values[j] > max_value
+                || (values[j] == max_value && indices[j] < best))
+        {
+            max_value = values[j];
+            best = indices[j];
+        }
+    for ( ; i < nu_children; ++i)
+    {
+        auto value = get_simd_select_value(data + i * layout.stride, layout,
+                                           expl_factor);
+        if (value > max_value)
+        {
+            max_value = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+#endif // LIBBOARDGAME_MCTS_SIMD_SELECT
+
+/** Get the fastest selection function supported by the CPU.
+    The CPU features are detected at runtime on the first call.
+    @return The function or null if no SIMD version is supported. */
+inline SimdSelectFunc get_simd_select_func()
+{
+#ifdef LIBBOARDGAME_MCTS_SIMD_SELECT
+    static const SimdSelectFunc func =
+            __builtin_cpu_supports("avx2") ? simd_select_avx2
+                                           : simd_select_sse2;
+    return func;
+#else
+    return nullptr;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_mcts
+
+#endif // LIBBOARDGAME_MCTS_SIMD_SELECT_H
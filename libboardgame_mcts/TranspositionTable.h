@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------------
+/** @file libboardgame_mcts/TranspositionTable.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBBOARDGAME_MCTS_TRANSPOSITION_TABLE_H
+#define LIBBOARDGAME_MCTS_TRANSPOSITION_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include "Atomic.h"
+#include "Node.h"
+
+namespace libboardgame_mcts {
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+/** Hash table that maps positions to the children of expanded nodes.
+    Used for sharing the children (and thereby their statistics) between
+    nodes that correspond to the same position reached by different move
+    sequences. The table stores only the location of the children in the
+    tree, so it needs to be cleared whenever the node storage of the tree is
+    rearranged (e.g. after pruning or reusing a subtree).<p>
+    Entries are stored without locking and can be overwritten by other
+    positions at any time. To detect entries that were partially written by
+    another thread, the key is stored XOR'ed with the data (see R. Hyatt,
+    T. Mann: A lock-less transposition table implementation for parallel
+    search chess engines. ICGA Journal 25(1), 2002).
+    @tparam S The number of entries (must be a power of two).
+    @tparam MT Whether the table is used in a multi-threaded search. */
+template<size_t S, bool MT>
+class TranspositionTable
+{
+public:
+    static constexpr size_t size = S;
+
+    static_assert(size > 0 && (size & (size - 1)) == 0,
+                  "size must be a power of two");
+
+
+    TranspositionTable();
+
+    void clear();
+
+    /** Find the children of a position.
+        @param hash The hash code of the position (must not be 0)
+        @param[out] first_child
+        @param[out] nu_children
+        @return @c true if the position was found. */
+    bool lookup(uint_least64_t hash, NodeIdx& first_child,
+                unsigned& nu_children) const;
+
+    /** Store the children of a position.
+        @param hash The hash code of the position (must not be 0)
+        @param first_child
+        @param nu_children Must be greater 0. */
+    void store(uint_least64_t hash, NodeIdx first_child, unsigned nu_children);
+
+private:
+    struct Entry
+    {
+        Atomic<uint_least64_t, MT> key;
+
+        Atomic<uint_least64_t, MT> data;
+    };
+
+    unique_ptr<Entry[]> m_entries;
+};
+
+template<size_t S, bool MT>
+TranspositionTable<S, MT>::TranspositionTable()
+    : m_entries(new Entry[size])
+{
+    clear();
+}
+
+template<size_t S, bool MT>
+void TranspositionTable<S, MT>::clear()
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        m_entries[i].key.store(0, memory_order_relaxed);
+        m_entries[i].data.store(0, memory_order_relaxed);
+    }
+}
+
+template<size_t S, bool MT>
+inline bool TranspositionTable<S, MT>::lookup(
+        uint_least64_t hash, NodeIdx& first_child, unsigned& nu_children) const
+{
+    LIBBOARDGAME_ASSERT(hash != 0);
+    auto& entry = m_entries[hash & (size - 1)];
+    // Acquire pairs with the release in store(), so that the initialization
+    // of the children is visible if the entry is valid
+    auto data = entry.data.load(memory_order_acquire);
+    if ((entry.key.load(memory_order_relaxed) ^ data) != hash)
+        return false;
+    first_child = static_cast<NodeIdx>(data >> 16);
+    nu_children = static_cast<unsigned>(data & 0xffff);
+    return nu_children > 0;
+}
+
+template<size_t S, bool MT>
+inline void TranspositionTable<S, MT>::store(
+        uint_least64_t hash, NodeIdx first_child, unsigned nu_children)
+{
+    LIBBOARDGAME_ASSERT(hash != 0);
+    LIBBOARDGAME_ASSERT(nu_children > 0 && nu_children <= 0xffff);
+    auto& entry = m_entries[hash & (size - 1)];
+    auto data = (static_cast<uint_least64_t>(first_child) << 16) | nu_children;
+    entry.key.store(hash ^ data, memory_order_relaxed);
+    entry.data.store(data, memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libboardgame_mcts
+
+#endif // LIBBOARDGAME_MCTS_TRANSPOSITION_TABLE_H
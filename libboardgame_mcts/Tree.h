@@ -8,8 +8,10 @@
 #define LIBBOARDGAME_MCTS_TREE_H
 
 #include <algorithm>
-#include <memory>
-#include "Node.h"
+#include <stdexcept>
+#include <vector>
+#include "NodeChunkPool.h"
+#include "libboardgame_base/Range.h"
 
 namespace libboardgame_mcts {
 
@@ -22,10 +24,18 @@ using libboardgame_base::Range;
     The nodes can be modified only through member functions of this class,
     so that it can guarantee an intact tree structure. The user has access to
     all nodes, but only as const references.<p>
-    The tree uses separate parts of the node storage for different threads,
-    so it can be used without locking in multi-threaded search. Not all
-    functions are thread-safe, only the ones that are used during a search
-    (e.g. expanding a node is thread-safe, but clear() is not) */
+    The nodes are stored in chunks taken from a NodeChunkPool. Each thread
+    creates new nodes in its current chunk and takes a new chunk from the
+    pool when the current chunk is full, so the tree can be used without
+    locking in multi-threaded search and all threads share the capacity of
+    the tree. The children of a node are always stored contiguously in a
+    single chunk. Not all functions are thread-safe, only the ones that are
+    used during a search (e.g. expanding a node is thread-safe, but clear() is
+    not).<p>
+    The children blocks start at positions in a chunk that are a multiple of
+    NodeChunkPool::align_nodes, so they start at a cache line and the
+    selection of a child reads a minimal number of cache lines. The nodes
+    skipped for this alignment are not counted in get_nu_nodes(). */
 template<typename N>
 class Tree
 {
@@ -40,6 +50,8 @@ public:
 
     using Float = typename Node::Float;
 
+    using Pool = NodeChunkPool<Node>;
+
     /** Range for iterating over the children of a node. */
     using Children = Range<const Node>;
 
@@ -65,8 +77,11 @@ public:
                      Float max_move_prior);
 
         /** Check if the tree still has the capacity for a given number
-            of children. */
-        bool check_capacity(unsigned short nu_children) const;
+            of children.
+            Takes a new chunk from the pool if the current chunk of the
+            thread is full. Must be called before the first call of
+            add_child(). */
+        bool check_capacity(unsigned short nu_children);
 
         /** Add new child.
             It needs to be checked first with check_capacity() that the tree
@@ -85,6 +100,8 @@ public:
         const Node* get_best_child() const;
 
     private:
+        Tree& m_tree;
+
         ThreadStorage& m_thread_storage;
 
         Float m_best_move_prior = -numeric_limits<Float>::max();
@@ -100,10 +117,20 @@ public:
 #endif
     };
 
-    Tree(size_t memory, unsigned nu_threads);
+    /** Constructor.
+        @param pool The pool for the node storage. Must exist longer than the
+        tree.
+        @param nu_threads
+        @param max_chunks The maximum number of chunks the tree may use
+        (including the chunk of the root node). */
+    Tree(Pool& pool, unsigned nu_threads, unsigned max_chunks);
+
+    ~Tree();
 
 
-    /** Remove all nodes but the root node. */
+    /** Remove all nodes but the root node.
+        Returns all chunks but the one containing the root node to the
+        pool. */
     void clear();
 
     const Node& get_root() const;
@@ -118,7 +145,7 @@ public:
 
     void set_expanding(const Node& node) { non_const(node).set_expanding(); }
 
-    void link_children(const Node& node, const Node* first_child,
+    void link_children(const Node& node, NodeIdx first_child,
                        unsigned nu_children);
 
     void add_value(const Node& node, Float v);
@@ -129,55 +156,104 @@ public:
 
     void inc_visit_count(const Node& node);
 
-    void swap(Tree& tree);
+    void add_visit_count(const Node& node, Float n);
 
-    /** Extract a subtree.
-        Note that you still have to re-initialize the value of the subtree
+    /** Make a subtree the new tree.
+        The data of the node is copied to the root node and all nodes that
+        are not in the subtree are removed with compact().
+        Note that you still have to re-initialize the value of the root node
         after the extraction because the value of the root node and the values
         of inner nodes have a different meaning.
-        @pre Target tree is empty (! target.get_root().has_children())
-        @param target The target tree
         @param node The root node of the subtree. */
-    void extract_subtree(Tree& target, const Node& node) const;
-
-    /** Copy a subtree.
-        The caller is responsible that the trees have the same number of
-        maximum nodes and that the target tree has room for the subtree.
-        @param target The target tree
-        @param target_node The target node
-        @param node The root node of the subtree.
-        @param min_count Don't copy subtrees of nodes below this count */
-    void copy_subtree(Tree& target, const Node& target_node, const Node& node,
-                      Float min_count) const;
+    void extract_subtree(const Node& node);
+
+    /** Remove unreachable nodes and the subtrees of nodes below a count.
+        Moves the remaining children blocks towards the beginning of the
+        node storage and returns chunks that are no longer needed to the pool.
+        Does not need additional node storage.
+        Invalidates all node references and indices apart from the root node.
+        @param min_count Don't keep the children of nodes below this count.
+        The children of the root node are always kept. */
+    void compact(Float min_count);
 
 private:
+    /** Children block that is kept during compact(). */
+    struct Block
+    {
+        /** Position of the block before compaction in the order of chunks
+            used by compact(). */
+        size_t key;
+
+        NodeIdx old_idx;
+
+        NodeIdx new_idx;
+
+        unsigned nu_children;
+    };
+
     struct ThreadStorage
     {
+        /** Start of the current chunk. */
         Node* begin;
 
+        /** End of the current chunk. */
         Node* end;
 
+        /** Next free node in the current chunk. */
         Node* next;
+
+        /** Node index of begin. */
+        NodeIdx begin_idx;
+
+        /** Number of nodes in the previous chunks of this thread. */
+        size_t nu_nodes;
+
+        /** Number of nodes in all chunks of this thread that were skipped
+            for aligning children blocks. */
+        size_t nu_padding;
+
+        /** The chunks used by this thread. */
+        vector<unsigned> chunks;
     };
 
 
-    unique_ptr<Node[]> m_nodes;
+    Pool* m_pool;
+
+    Node* const* m_chunk_table;
+
+    Node* m_root;
 
     unique_ptr<ThreadStorage[]> m_thread_storage;
 
     unsigned m_nu_threads;
 
-    size_t m_max_nodes;
+    unsigned m_max_chunks;
 
-    size_t m_nodes_per_thread;
+    /** Number of chunks used by the tree.
+        Can be greater than m_max_chunks after a failed new_chunk(). */
+    atomic<unsigned> m_nu_chunks;
 
 
     bool contains(const Node& node) const;
 
-    void copy_recurse(Tree& target, const Node& target_node, const Node& node,
-                      Float min_count) const;
+    void collect_blocks(const Node& node, Float min_count,
+                        const vector<unsigned>& rank, vector<bool>& is_visited,
+                        vector<Block>& blocks);
+
+    NodeIdx get_compacted_idx(NodeIdx old_idx, const vector<unsigned>& rank,
+                              const vector<Block>& blocks) const;
+
+    size_t get_key(NodeIdx idx, const vector<unsigned>& rank) const;
+
+    NodeIdx get_idx(const ThreadStorage& thread_storage,
+                    const Node* node) const;
 
-    unsigned get_thread_storage(const Node& node) const;
+    /** Get the first aligned position in a chunk at or after a position.
+        The result can be greater than the chunk size. */
+    static size_t align_pos(size_t pos);
+
+    /** Take a new chunk from the pool for a thread. */
+    bool new_chunk(ThreadStorage& thread_storage);
 
     Node& non_const(const Node& node) const;
 };
@@ -186,7 +262,8 @@ template<typename N>
 inline Tree<N>::NodeExpander::NodeExpander(
         unsigned thread_id, Tree& tree, [[maybe_unused]] Float child_min_count,
         [[maybe_unused]] Float max_move_prior)
-    : m_thread_storage(tree.m_thread_storage[thread_id]),
+    : m_tree(tree),
+      m_thread_storage(tree.m_thread_storage[thread_id]),
       m_first_child(m_thread_storage.next),
       m_best_child(nullptr)
 {
@@ -217,34 +294,32 @@ inline void Tree<N>::NodeExpander::add_child(const Move& mv, Float value,
 }
 
 template<typename N>
-inline bool Tree<N>::NodeExpander::check_capacity(
-        unsigned short nu_children) const
-{
-    return m_thread_storage.end - m_thread_storage.next  >= nu_children;
-}
-
-template<typename N>
-inline auto Tree<N>::NodeExpander::get_best_child() const -> const Node*
-{
-    return m_best_child;
-}
-
-template<typename N>
-inline auto Tree<N>::get_children(const Node& node) const -> Children
+inline bool Tree<N>::NodeExpander::check_capacity(unsigned short nu_children)
 {
-    auto nu_children = node.get_nu_children();
-    if (nu_children > 0)
+    auto& next = m_thread_storage.next;
+    auto& begin = m_thread_storage.begin;
+    auto pos = static_cast<size_t>(next - begin);
+    auto padding = static_cast<ptrdiff_t>(align_pos(pos) - pos);
+    if (m_thread_storage.end - next - padding >= nu_children)
     {
-        auto begin = &get_node(node.get_first_child());
-        return Children(begin, begin + nu_children);
+        LIBBOARDGAME_ASSERT(next == m_first_child);
+        next += padding;
+        m_thread_storage.nu_padding += static_cast<size_t>(padding);
+        m_first_child = next;
+        return true;
     }
-    return Children(nullptr, nullptr);
+    LIBBOARDGAME_ASSERT(next == m_first_child);
+    if (nu_children > m_tree.m_pool->get_chunk_size()
+            || ! m_tree.new_chunk(m_thread_storage))
+        return false;
+    m_first_child = m_thread_storage.next;
+    return true;
 }
 
 template<typename N>
-inline auto Tree<N>::get_node(NodeIdx i) const -> const Node&
+inline auto Tree<N>::NodeExpander::get_best_child() const -> const Node*
 {
-    return m_nodes[i];
+    return m_best_child;
 }
 
 template<typename N>
@@ -252,42 +327,37 @@ inline void Tree<N>::NodeExpander::link_children(Tree& tree, const Node& node)
 {
     auto nu_children =
             static_cast<unsigned>(m_thread_storage.next - m_first_child);
-    tree.link_children(node, m_first_child, nu_children);
+    tree.link_children(node, tree.get_idx(m_thread_storage, m_first_child),
+                       nu_children);
 }
 
 
 template<typename N>
-Tree<N>::Tree(size_t memory, unsigned nu_threads)
+Tree<N>::Tree(Pool& pool, unsigned nu_threads, unsigned max_chunks)
+    : m_pool(&pool),
+      m_chunk_table(pool.get_chunk_table())
 {
     if (nu_threads == 0)
         nu_threads = 1;
-    auto max_nodes = memory / sizeof(Node);
-    // We need at least one node per thread
-    max_nodes = max(max_nodes, static_cast<size_t>(nu_threads));
-    // It doesn't make sense to set max_nodes higher than what can be accessed
-    // with NodeIdx
-    max_nodes =
-        min(max_nodes, static_cast<size_t>(numeric_limits<NodeIdx>::max()));
     m_nu_threads = nu_threads;
-    m_max_nodes = max_nodes;
-
-    // Using make_unique<Node[]>(max_nodes) slows down the array creation and
-    // thereby the startup time of Pentobi with GCC 7/8 because the compiler
-    // does not optimize away the call to the empty Move() constructor (last
-    // tested with GCC 7.2.0 and GCC 8.0.0 on Ubuntu 17.10).
-    m_nodes.reset(new Node[max_nodes]);
-
+    m_max_chunks = max(max_chunks, 1u);
     m_thread_storage = make_unique<ThreadStorage[]>(nu_threads);
-    m_nodes_per_thread = max_nodes / nu_threads;
-    for (unsigned i = 0; i < nu_threads; ++i)
-    {
-        auto& thread_storage = m_thread_storage[i];
-        thread_storage.begin = m_nodes.get() + i * m_nodes_per_thread;
-        thread_storage.end = thread_storage.begin + m_nodes_per_thread;
-    }
+    unsigned chunk;
+    if (! pool.acquire(chunk))
+        throw runtime_error("no free chunk for root node");
+    m_thread_storage[0].chunks.push_back(chunk);
+    m_root = pool.get_chunk(chunk);
     clear();
 }
 
+template<typename N>
+Tree<N>::~Tree()
+{
+    for (unsigned i = 0; i < m_nu_threads; ++i)
+        for (auto chunk : m_thread_storage[i].chunks)
+            m_pool->release(chunk);
+}
+
 template<typename N>
 inline void Tree<N>::add_value(const Node& node, Float v)
 {
@@ -303,72 +373,239 @@ inline void Tree<N>::add_value(const Node& node, Float v, Float weight)
 template<typename N>
 void Tree<N>::clear()
 {
-    m_thread_storage[0].next = m_thread_storage[0].begin + 1;
-    for (unsigned i = 1; i < m_nu_threads; ++i)
-        m_thread_storage[i].next = m_thread_storage[i].begin;
-    m_nodes[0].init_root();
+    for (unsigned i = 0; i < m_nu_threads; ++i)
+    {
+        auto& thread_storage = m_thread_storage[i];
+        auto& chunks = thread_storage.chunks;
+        // The first chunk of thread 0 contains the root node
+        size_t keep = (i == 0 ? 1 : 0);
+        for (auto j = keep; j < chunks.size(); ++j)
+            m_pool->release(chunks[j]);
+        chunks.resize(keep);
+        thread_storage.nu_nodes = 0;
+        thread_storage.nu_padding = 0;
+        thread_storage.begin = nullptr;
+        thread_storage.end = nullptr;
+        thread_storage.next = nullptr;
+    }
+    auto& thread_storage = m_thread_storage[0];
+    thread_storage.begin = m_root;
+    thread_storage.end = m_root + m_pool->get_chunk_size();
+    thread_storage.next = m_root + 1;
+    thread_storage.begin_idx = Pool::get_idx(thread_storage.chunks[0], 0);
+    m_nu_chunks.store(1);
+    m_root->init_root();
 }
 
 template<typename N>
-bool Tree<N>::contains(const Node& node) const
+void Tree<N>::collect_blocks(const Node& node, Float min_count,
+                             const vector<unsigned>& rank,
+                             vector<bool>& is_visited, vector<Block>& blocks)
 {
-    return &node >= m_nodes.get() && &node < m_nodes.get() + m_max_nodes;
+    LIBBOARDGAME_ASSERT(node.get_nu_children() > 0);
+    auto first_child = node.get_first_child();
+    auto key = get_key(first_child, rank);
+    // Children can be shared by several nodes if the search uses
+    // transpositions
+    if (is_visited[key])
+        return;
+    is_visited[key] = true;
+    blocks.push_back({key, first_child, 0,
+                      static_cast<unsigned>(node.get_nu_children())});
+    for (auto& child : get_children(node))
+        if (child.get_nu_children() <= 0 || child.get_visit_count() < min_count)
+            non_const(child).unlink_children_st();
+        else
+            collect_blocks(child, min_count, rank, is_visited, blocks);
 }
 
 template<typename N>
-void Tree<N>::copy_subtree(Tree& target, const Node& target_node,
-                           const Node& node, Float min_count) const
+void Tree<N>::compact(Float min_count)
 {
-    target.non_const(target_node).copy_data_from(node);
-    if (node.get_nu_children() > 0)
-        copy_recurse(target, target_node, node, min_count);
+    auto chunk_size = m_pool->get_chunk_size();
+    // Put the chunks of all threads in a single order, which starts with the
+    // chunk containing the root node
+    vector<unsigned> chunks;
+    for (unsigned i = 0; i < m_nu_threads; ++i)
+        for (auto chunk : m_thread_storage[i].chunks)
+            chunks.push_back(chunk);
+    vector<unsigned> rank(m_pool->get_nu_chunks());
+    for (unsigned i = 0; i < chunks.size(); ++i)
+        rank[chunks[i]] = i;
+
+    vector<Block> blocks;
+    if (m_root->get_nu_children() > 0)
+    {
+        vector<bool> is_visited(chunks.size() * chunk_size, false);
+        collect_blocks(*m_root, min_count, rank, is_visited, blocks);
+    }
     else
-        target.non_const(target_node).unlink_children_st();
+        m_root->unlink_children_st();
+    sort(blocks.begin(), blocks.end(),
+         [](const Block& b1, const Block& b2) { return b1.key < b2.key; });
+
+    // Assign the new positions. A block never gets a position behind its old
+    // position, so the blocks can be moved in this order without overwriting
+    // blocks that were not moved yet. This holds also with the alignment of
+    // the new positions because the old positions were aligned too.
+    unsigned nu_chunks = 1;
+    size_t pos = 1;
+    size_t nu_nodes = 1;
+    size_t nu_padding = 0;
+    for (auto& block : blocks)
+    {
+        auto aligned_pos = min(align_pos(pos), chunk_size);
+        if (chunk_size - aligned_pos < block.nu_children)
+        {
+            nu_padding += chunk_size - pos;
+            ++nu_chunks;
+            pos = 0;
+        }
+        else
+        {
+            nu_padding += aligned_pos - pos;
+            pos = aligned_pos;
+        }
+        block.new_idx = Pool::get_idx(chunks[nu_chunks - 1], pos);
+        LIBBOARDGAME_ASSERT(get_key(block.new_idx, rank) <= block.key);
+        pos += block.nu_children;
+        nu_nodes += block.nu_children;
+    }
+
+    // Move the blocks and update the links to the children
+    for (auto& block : blocks)
+    {
+        auto src = &get_node(block.old_idx);
+        auto dest = &non_const(get_node(block.new_idx));
+        for (unsigned i = 0; i < block.nu_children; ++i)
+        {
+            auto& node = src[i];
+            auto nu_children = node.get_nu_children();
+            auto first_child = node.get_first_child();
+            if (dest != src)
+                dest[i].copy_data_from(node);
+            if (nu_children > 0)
+                dest[i].link_children_st(
+                            get_compacted_idx(first_child, rank, blocks),
+                            static_cast<unsigned>(nu_children));
+            else
+                dest[i].unlink_children_st();
+        }
+    }
+    auto nu_children = m_root->get_nu_children();
+    if (nu_children > 0)
+        m_root->link_children_st(
+                    get_compacted_idx(m_root->get_first_child(), rank, blocks),
+                    static_cast<unsigned>(nu_children));
+
+    for (auto i = nu_chunks; i < chunks.size(); ++i)
+        m_pool->release(chunks[i]);
+    for (unsigned i = 0; i < m_nu_threads; ++i)
+    {
+        auto& thread_storage = m_thread_storage[i];
+        thread_storage.chunks.clear();
+        thread_storage.nu_nodes = 0;
+        thread_storage.nu_padding = 0;
+        thread_storage.begin = nullptr;
+        thread_storage.end = nullptr;
+        thread_storage.next = nullptr;
+    }
+    auto& thread_storage = m_thread_storage[0];
+    thread_storage.chunks.assign(chunks.begin(), chunks.begin() + nu_chunks);
+    auto last_chunk = chunks[nu_chunks - 1];
+    thread_storage.begin = m_pool->get_chunk(last_chunk);
+    thread_storage.end = thread_storage.begin + chunk_size;
+    thread_storage.next = thread_storage.begin + pos;
+    thread_storage.begin_idx = Pool::get_idx(last_chunk, 0);
+    thread_storage.nu_nodes = nu_nodes + nu_padding - pos;
+    thread_storage.nu_padding = nu_padding;
+    m_nu_chunks.store(nu_chunks);
 }
 
 template<typename N>
-void Tree<N>::copy_recurse(Tree& target, const Node& target_node,
-                           const Node& node, Float min_count) const
+bool Tree<N>::contains(const Node& node) const
 {
-    LIBBOARDGAME_ASSERT(target.m_max_nodes == m_max_nodes);
-    LIBBOARDGAME_ASSERT(target.m_nu_threads == m_nu_threads);
-    LIBBOARDGAME_ASSERT(contains(node));
-    LIBBOARDGAME_ASSERT(node.get_nu_children() > 0);
-    auto nu_children = static_cast<unsigned>(node.get_nu_children());
-    auto& first_child = get_node(node.get_first_child());
-    // Create target children in the equivalent thread storage as in source.
-    // This ensures that the thread storage will not overflow (because the
-    // trees have identical nu_threads/max_nodes)
-    ThreadStorage& thread_storage =
-        target.m_thread_storage[get_thread_storage(first_child)];
-    auto target_child = thread_storage.next;
-    auto target_first_child =
-        static_cast<NodeIdx>(target_child - target.m_nodes.get());
-    target.non_const(target_node).link_children_st(target_first_child,
-                                                   nu_children);
-    thread_storage.next += nu_children;
-    LIBBOARDGAME_ASSERT(thread_storage.next < thread_storage.end);
-    auto end = &first_child + nu_children;
-    for (auto i = &first_child; i != end; ++i, ++target_child)
-    {
-        target_child->copy_data_from(*i);
-        if (i->get_nu_children() <= 0 || i->get_visit_count() < min_count)
+    auto chunk_size = m_pool->get_chunk_size();
+    for (unsigned i = 0; i < m_nu_threads; ++i)
+        for (auto chunk : m_thread_storage[i].chunks)
         {
-            target_child->unlink_children_st();
-            continue;
+            auto begin = m_pool->get_chunk(chunk);
+            if (&node >= begin && &node < begin + chunk_size)
+                return true;
         }
-        copy_recurse(target, *target_child, *i, min_count);
-    }
+    return false;
 }
 
 template<typename N>
-void Tree<N>::extract_subtree(Tree& target, const Node& node) const
+void Tree<N>::extract_subtree(const Node& node)
 {
     LIBBOARDGAME_ASSERT(contains(node));
-    LIBBOARDGAME_ASSERT(&target != this);
-    LIBBOARDGAME_ASSERT(target.m_max_nodes == m_max_nodes);
-    LIBBOARDGAME_ASSERT(target.get_root().get_nu_children() <= 0);
-    copy_subtree(target, target.m_nodes[0], node, 0);
+    if (&node != m_root)
+    {
+        auto nu_children = node.get_nu_children();
+        m_root->copy_data_from(node);
+        if (nu_children > 0)
+            m_root->link_children_st(node.get_first_child(),
+                                     static_cast<unsigned>(nu_children));
+        else
+            m_root->unlink_children_st();
+    }
+    compact(0);
+}
+
+template<typename N>
+inline auto Tree<N>::get_children(const Node& node) const -> Children
+{
+    auto nu_children = node.get_nu_children();
+    if (nu_children > 0)
+    {
+        auto begin = &get_node(node.get_first_child());
+        return Children(begin, begin + nu_children);
+    }
+    return Children(nullptr, nullptr);
+}
+
+template<typename N>
+NodeIdx Tree<N>::get_compacted_idx(NodeIdx old_idx,
+                                   const vector<unsigned>& rank,
+                                   const vector<Block>& blocks) const
+{
+    auto key = get_key(old_idx, rank);
+    auto i = lower_bound(blocks.begin(), blocks.end(), key,
+                         [](const Block& b, size_t k) { return b.key < k; });
+    LIBBOARDGAME_ASSERT(i != blocks.end() && i->key == key);
+    return i->new_idx;
+}
+
+template<typename N>
+inline size_t Tree<N>::align_pos(size_t pos)
+{
+    auto align = Pool::align_nodes;
+    return (pos + align - 1) / align * align;
+}
+
+template<typename N>
+inline NodeIdx Tree<N>::get_idx(const ThreadStorage& thread_storage,
+                                const Node* node) const
+{
+    LIBBOARDGAME_ASSERT(node >= thread_storage.begin);
+    LIBBOARDGAME_ASSERT(node < thread_storage.end);
+    return thread_storage.begin_idx
+            + static_cast<NodeIdx>(node - thread_storage.begin);
+}
+
+template<typename N>
+inline size_t Tree<N>::get_key(NodeIdx idx,
+                               const vector<unsigned>& rank) const
+{
+    return rank[idx >> Pool::chunk_bits] * m_pool->get_chunk_size()
+            + (idx & Pool::chunk_mask);
+}
+
+template<typename N>
+inline auto Tree<N>::get_node(NodeIdx i) const -> const Node&
+{
+    return m_chunk_table[i >> Pool::chunk_bits][i & Pool::chunk_mask];
 }
 
 template<typename N>
@@ -378,7 +615,10 @@ size_t Tree<N>::get_nu_nodes() const
     for (unsigned i = 0; i < m_nu_threads; ++i)
     {
         auto& thread_storage = m_thread_storage[i];
-        result += thread_storage.next - thread_storage.begin;
+        result += thread_storage.nu_nodes
+                + static_cast<size_t>(thread_storage.next
+                                      - thread_storage.begin)
+                - thread_storage.nu_padding;
     }
     return result;
 }
@@ -386,15 +626,13 @@ size_t Tree<N>::get_nu_nodes() const
 template<typename N>
 inline auto Tree<N>::get_root() const -> const Node&
 {
-    return m_nodes[0];
+    return *m_root;
 }
 
-/** Get the thread storage a node belongs to. */
 template<typename N>
-inline unsigned Tree<N>::get_thread_storage(const Node& node) const
+inline void Tree<N>::add_visit_count(const Node& node, Float n)
 {
-    size_t diff = &node - m_nodes.get();
-    return static_cast<unsigned>(diff / m_nodes_per_thread);
+    non_const(node).add_visit_count(n);
 }
 
 template<typename N>
@@ -404,13 +642,29 @@ inline void Tree<N>::inc_visit_count(const Node& node)
 }
 
 template<typename N>
-inline void Tree<N>::link_children(const Node& node, const Node* first_child,
+inline void Tree<N>::link_children(const Node& node, NodeIdx first_child,
                                    unsigned nu_children)
 {
-    auto first_child_idx = static_cast<NodeIdx>(first_child - m_nodes.get());
-    LIBBOARDGAME_ASSERT(first_child_idx > 0);
-    LIBBOARDGAME_ASSERT(first_child_idx < m_max_nodes);
-    non_const(node).link_children(first_child_idx, nu_children);
+    LIBBOARDGAME_ASSERT(&get_node(first_child) != m_root);
+    LIBBOARDGAME_ASSERT(contains(get_node(first_child)));
+    non_const(node).link_children(first_child, nu_children);
+}
+
+template<typename N>
+bool Tree<N>::new_chunk(ThreadStorage& thread_storage)
+{
+    if (m_nu_chunks.fetch_add(1) >= m_max_chunks)
+        return false;
+    unsigned chunk;
+    if (! m_pool->acquire(chunk))
+        return false;
+    thread_storage.nu_nodes += thread_storage.next - thread_storage.begin;
+    thread_storage.chunks.push_back(chunk);
+    thread_storage.begin = m_pool->get_chunk(chunk);
+    thread_storage.end = thread_storage.begin + m_pool->get_chunk_size();
+    thread_storage.next = thread_storage.begin;
+    thread_storage.begin_idx = Pool::get_idx(chunk, 0);
+    return true;
 }
 
 /** Convert a const reference to node from user to a non-const reference.
@@ -429,26 +683,6 @@ inline void Tree<N>::add_value_remove_loss(const Node& node, Float v)
     non_const(node).add_value_remove_loss(v);
 }
 
-template<typename N>
-void Tree<N>::swap(Tree& tree)
-{
-    // Reminder to update this function when the class gets additional members
-    struct Dummy
-    {
-        unsigned m_nu_threads;
-        size_t m_max_nodes;
-        size_t m_nodes_per_thread;
-        unique_ptr<ThreadStorage> m_thread_storage;
-        unique_ptr<Node[]> m_nodes;
-    };
-    static_assert(sizeof(Tree) == sizeof(Dummy));
-    std::swap(m_nu_threads, tree.m_nu_threads);
-    std::swap(m_max_nodes, tree.m_max_nodes);
-    std::swap(m_nodes_per_thread, tree.m_nodes_per_thread);
-    m_thread_storage.swap(tree.m_thread_storage);
-    m_nodes.swap(tree.m_nodes);
-}
-
 //-----------------------------------------------------------------------------
 
 } // namespace libboardgame_mcts
@@ -6,6 +6,9 @@
 
 #include "libboardgame_mcts/Node.h"
 
+#include <thread>
+#include <vector>
+#include "libboardgame_mcts/NodeChunkPool.h"
 #include "libboardgame_test/Test.h"
 
 using namespace std;
@@ -34,4 +37,52 @@ LIBBOARDGAME_TEST_CASE(libboardgame_mcts_node_add_value_remove_loss)
     LIBBOARDGAME_CHECK_CLOSE(node.get_value(), 3.5f, 1e-4f);
 }
 
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_node_packed_add_value_remove_loss)
+{
+    libboardgame_mcts::Node<int, float, true, true> node;
+    node.init(0, 0.5, 0, 1);
+    node.add_value(5);
+    LIBBOARDGAME_CHECK_CLOSE(node.get_value(), 5.f, 1e-4f);
+    LIBBOARDGAME_CHECK_EQUAL(node.get_value_count(), 1.f);
+    node.add_value(0);
+    LIBBOARDGAME_CHECK_CLOSE(node.get_value(), 2.5f, 1e-4f);
+    node.add_value_remove_loss(2);
+    LIBBOARDGAME_CHECK_CLOSE(node.get_value(), 3.5f, 1e-4f);
+    LIBBOARDGAME_CHECK_EQUAL(node.get_value_count(), 2.f);
+}
+
+/** Test that nodes with a 16-bit move like in libpentobi_mcts can be
+    aligned such that blocks of NodeChunkPool::align_nodes nodes fill whole
+    cache lines. */
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_node_layout)
+{
+    using Node = libboardgame_mcts::Node<unsigned short, float, true>;
+    using Pool = libboardgame_mcts::NodeChunkPool<Node>;
+    LIBBOARDGAME_CHECK(Pool::align_nodes > 1);
+    LIBBOARDGAME_CHECK_EQUAL(Pool::align_nodes * sizeof(Node)
+                             % Pool::cache_line_size, size_t(0));
+    LIBBOARDGAME_CHECK_EQUAL(Pool::cache_line_size % alignof(Node),
+                             size_t(0));
+}
+
+/** Test that packed values lose no updates in multi-threaded mode. */
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_node_packed_concurrent_add_value)
+{
+    libboardgame_mcts::Node<int, float, true, true> node;
+    node.init(0, 0, 0, 1);
+    const unsigned nu_threads = 4;
+    const unsigned nu_values = 10000;
+    vector<thread> threads;
+    for (unsigned i = 0; i < nu_threads; ++i)
+        threads.emplace_back([&node] {
+            for (unsigned j = 0; j < nu_values; ++j)
+                node.add_value(1);
+        });
+    for (auto& t : threads)
+        t.join();
+    LIBBOARDGAME_CHECK_EQUAL(node.get_value_count(),
+                             static_cast<float>(nu_threads * nu_values));
+    LIBBOARDGAME_CHECK_CLOSE(node.get_value(), 1.f, 1e-4f);
+}
+
 //-----------------------------------------------------------------------------
@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libboardgame_mcts/SimdSelectTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libboardgame_mcts/SimdSelect.h"
+
+#include <vector>
+#include "libboardgame_test/Test.h"
+
+using namespace std;
+using libboardgame_mcts::SimdSelectFunc;
+using libboardgame_mcts::SimdSelectLayout;
+using libboardgame_mcts::simd_select_scalar;
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+/** Check a selection function against the scalar version.
+    Uses values that are exactly representable and have many ties, so
+    the results must be identical. */
+void check_select(SimdSelectFunc select)
+{
+    const SimdSelectLayout layout = {6, 0, 1, 2};
+    unsigned random = 1;
+    for (unsigned nu_children = 1; nu_children < 100; ++nu_children)
+    {
+        vector<float> data(nu_children * layout.stride, 0);
+        for (unsigned i = 0; i < nu_children; ++i)
+        {
+            random = random * 1103515245 + 12345;
+            auto p = &data[i * layout.stride];
+            p[layout.value] = static_cast<float>((random >> 16) % 4) * 0.25f;
+            p[layout.count] = static_cast<float>(1u << ((random >> 20) % 3));
+            p[layout.prior] = static_cast<float>((random >> 24) % 3) * 0.5f;
+        }
+        LIBBOARDGAME_CHECK_EQUAL(
+                    select(data.data(), layout, nu_children, 0.5f),
+                    simd_select_scalar(data.data(), layout, nu_children,
+                                       0.5f));
+    }
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_simd_select)
+{
+#ifdef LIBBOARDGAME_MCTS_SIMD_SELECT
+    check_select(libboardgame_mcts::simd_select_sse2);
+    if (__builtin_cpu_supports("avx2"))
+        check_select(libboardgame_mcts::simd_select_avx2);
+#endif
+    if (libboardgame_mcts::get_simd_select_func() != nullptr)
+        check_select(libboardgame_mcts::get_simd_select_func());
+}
+
+//-----------------------------------------------------------------------------
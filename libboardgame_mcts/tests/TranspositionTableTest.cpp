@@ -0,0 +1,46 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libboardgame_mcts/TranspositionTableTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libboardgame_mcts/TranspositionTable.h"
+
+#include "libboardgame_test/Test.h"
+
+using namespace std;
+using libboardgame_mcts::NodeIdx;
+using libboardgame_mcts::TranspositionTable;
+
+//-----------------------------------------------------------------------------
+
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_transposition_table_basic)
+{
+    TranspositionTable<16, true> table;
+    NodeIdx first_child;
+    unsigned nu_children;
+    LIBBOARDGAME_CHECK(! table.lookup(0x1234, first_child, nu_children));
+    table.store(0x1234, 100000, 37);
+    LIBBOARDGAME_CHECK(table.lookup(0x1234, first_child, nu_children));
+    LIBBOARDGAME_CHECK_EQUAL(first_child, 100000u);
+    LIBBOARDGAME_CHECK_EQUAL(nu_children, 37u);
+    // Same index in table but different hash
+    LIBBOARDGAME_CHECK(! table.lookup(0x1244, first_child, nu_children));
+    table.clear();
+    LIBBOARDGAME_CHECK(! table.lookup(0x1234, first_child, nu_children));
+}
+
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_transposition_table_overwrite)
+{
+    TranspositionTable<16, false> table;
+    NodeIdx first_child;
+    unsigned nu_children;
+    table.store(0x1234, 5, 1);
+    table.store(0x5674, 7, 2);
+    LIBBOARDGAME_CHECK(! table.lookup(0x1234, first_child, nu_children));
+    LIBBOARDGAME_CHECK(table.lookup(0x5674, first_child, nu_children));
+    LIBBOARDGAME_CHECK_EQUAL(first_child, 7u);
+    LIBBOARDGAME_CHECK_EQUAL(nu_children, 2u);
+}
+
+//-----------------------------------------------------------------------------
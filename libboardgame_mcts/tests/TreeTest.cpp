@@ -0,0 +1,173 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libboardgame_mcts/TreeTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libboardgame_mcts/Tree.h"
+
+#include <cstdint>
+#include "libboardgame_test/Test.h"
+
+using namespace std;
+using libboardgame_mcts::NodeChunkPool;
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+struct Move
+{
+    static constexpr unsigned range = 100000;
+
+    static Move null() { return {0}; }
+
+    unsigned i;
+};
+
+using Node = libboardgame_mcts::Node<Move, float, true>;
+
+using Tree = libboardgame_mcts::Tree<Node>;
+
+const size_t chunk_size = size_t(1) << NodeChunkPool<Node>::chunk_bits;
+
+void expand(Tree& tree, unsigned thread_id, const Node& node,
+            unsigned nu_children, bool expect_success = true)
+{
+    Tree::NodeExpander expander(thread_id, tree, 0, 1);
+    bool success = expander.check_capacity(
+                static_cast<unsigned short>(nu_children));
+    LIBBOARDGAME_CHECK_EQUAL(success, expect_success);
+    if (! success)
+        return;
+    for (unsigned i = 0; i < nu_children; ++i)
+        expander.add_child({i}, 0.5, 0, 1);
+    expander.link_children(tree, node);
+}
+
+bool is_aligned(const Tree::Children& children)
+{
+    return reinterpret_cast<uintptr_t>(children.begin())
+            % NodeChunkPool<Node>::cache_line_size == 0;
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+/** Test that threads take new chunks from the pool as needed and that the
+    chunks are returned to the pool by clear(). */
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_tree_chunks)
+{
+    NodeChunkPool<Node> pool(8 * chunk_size * sizeof(Node));
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_chunks(), 8u);
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_chunk_size(), chunk_size);
+    Tree tree(pool, 2, 3);
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 1u);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(1));
+    auto& root = tree.get_root();
+    expand(tree, 1, root, 30000);
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 2u);
+    auto children = tree.get_root_children().begin();
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_root_children().size(), size_t(30000));
+    LIBBOARDGAME_CHECK_EQUAL(children[29999].get_move().i, 29999u);
+    expand(tree, 0, children[0], 30000);
+    expand(tree, 1, children[1], 30000);
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 2u);
+    expand(tree, 1, children[2], 30000);
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 3u);
+    expand(tree, 0, children[3], 30000);
+    // The tree may use only 3 chunks
+    expand(tree, 0, children[4], 30000, false);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(1 + 5 * 30000));
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_children(children[2]).size(),
+                             size_t(30000));
+    tree.clear();
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 1u);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(1));
+    LIBBOARDGAME_CHECK(tree.get_root_children().empty());
+}
+
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_tree_compact)
+{
+    NodeChunkPool<Node> pool(8 * chunk_size * sizeof(Node));
+    Tree tree(pool, 2, 8);
+    auto& root = tree.get_root();
+    expand(tree, 0, root, 3);
+    auto children = tree.get_root_children().begin();
+    expand(tree, 1, children[0], 30000);
+    expand(tree, 1, children[1], 30000);
+    expand(tree, 1, children[2], 30000);
+    auto grand_children = tree.get_children(children[1]).begin();
+    expand(tree, 0, grand_children[7], 5);
+    tree.inc_visit_count(children[0]);
+    tree.inc_visit_count(children[1]);
+    tree.inc_visit_count(children[1]);
+    tree.inc_visit_count(grand_children[7]);
+    tree.inc_visit_count(grand_children[7]);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(90009));
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 3u);
+    tree.compact(2);
+    // Kept are the root, its children, the children of the second child and
+    // the children of its 8th child
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(30009));
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 1u);
+    children = tree.get_root_children().begin();
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_root_children().size(), size_t(3));
+    LIBBOARDGAME_CHECK_EQUAL(children[2].get_move().i, 2u);
+    LIBBOARDGAME_CHECK(tree.get_children(children[0]).empty());
+    LIBBOARDGAME_CHECK(tree.get_children(children[2]).empty());
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_children(children[1]).size(),
+                             size_t(30000));
+    grand_children = tree.get_children(children[1]).begin();
+    LIBBOARDGAME_CHECK_EQUAL(grand_children[7].get_move().i, 7u);
+    LIBBOARDGAME_CHECK_EQUAL(grand_children[7].get_visit_count(), 2.f);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_children(grand_children[7]).size(),
+                             size_t(5));
+    // Extract the subtree of the 8th grand child
+    tree.extract_subtree(grand_children[7]);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(6));
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_root().get_visit_count(), 2.f);
+    children = tree.get_root_children().begin();
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_root_children().size(), size_t(5));
+    LIBBOARDGAME_CHECK_EQUAL(children[4].get_move().i, 4u);
+    // New nodes are created after the compacted nodes
+    expand(tree, 1, children[4], 3);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(9));
+    LIBBOARDGAME_CHECK_EQUAL(pool.get_nu_used(), 2u);
+}
+
+/** Test that children blocks start at a cache line and that the nodes
+    skipped for the alignment are not counted. */
+LIBBOARDGAME_TEST_CASE(libboardgame_mcts_tree_align)
+{
+    if (NodeChunkPool<Node>::align_nodes == 1)
+        return;
+    NodeChunkPool<Node> pool(8 * chunk_size * sizeof(Node));
+    Tree tree(pool, 2, 8);
+    auto& root = tree.get_root();
+    expand(tree, 0, root, 3);
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_root_children()));
+    auto children = tree.get_root_children().begin();
+    expand(tree, 0, children[0], 5);
+    expand(tree, 0, children[1], 7);
+    expand(tree, 1, children[2], 1);
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_children(children[0])));
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_children(children[1])));
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_children(children[2])));
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(17));
+    tree.inc_visit_count(children[0]);
+    tree.inc_visit_count(children[2]);
+    tree.compact(1);
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(10));
+    children = tree.get_root_children().begin();
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_root_children()));
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_children(children[0])));
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_children(children[2])));
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_children(children[0]).size(), size_t(5));
+    expand(tree, 1, children[1], 2);
+    LIBBOARDGAME_CHECK(is_aligned(tree.get_children(children[1])));
+    LIBBOARDGAME_CHECK_EQUAL(tree.get_nu_nodes(), size_t(12));
+}
+
+//-----------------------------------------------------------------------------
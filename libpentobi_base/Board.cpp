@@ -292,6 +292,7 @@ void Board::init(Variant variant, const Setup* setup)
     {
         auto& state = m_state_color[c];
         state.forbidden.fill(false, *m_geo);
+        state.forbidden_set.clear();
         state.is_attach_point.fill(false, *m_geo);
         state.pieces_left.clear();
         state.nu_onboard_pieces = 0;
@@ -306,6 +307,7 @@ void Board::init(Variant variant, const Setup* setup)
         m_attach_points[c].clear();
     }
     m_state_base.nu_onboard_pieces_all = 0;
+    m_state_base.hash = 0;
     if (setup == nullptr)
     {
         m_setup.clear();
@@ -397,6 +399,8 @@ void Board::init_variant(Variant variant)
     m_move_info_array = m_bc->get_move_info_array();
     m_move_info_ext_array = m_bc->get_move_info_ext_array();
     m_move_info_ext_2_array = m_bc->get_move_info_ext_2_array();
+    m_move_mask_array = m_bc->get_move_mask_array();
+    m_zobrist_move_array = m_bc->get_zobrist_move_array();
     m_starting_points.init(variant, *m_geo);
     if (m_piece_set == PieceSet::gembloq)
         m_needed_starting_points = 4;
@@ -533,6 +537,7 @@ void Board::take_snapshot()
     m_snapshot.state_base.to_play = m_state_base.to_play;
     m_snapshot.state_base.nu_onboard_pieces_all =
         m_state_base.nu_onboard_pieces_all;
+    m_snapshot.state_base.hash = m_state_base.hash;
     m_snapshot.state_base.point_state.copy_from(m_state_base.point_state,
                                                 *m_geo);
     for (Color c : get_colors())
@@ -541,6 +546,7 @@ void Board::take_snapshot()
         const auto& state = m_state_color[c];
         auto& snapshot_state = m_snapshot.state_color[c];
         snapshot_state.forbidden.copy_from(state.forbidden, *m_geo);
+        snapshot_state.forbidden_set.copy_from(state.forbidden_set, *m_geo);
         snapshot_state.is_attach_point.copy_from(state.is_attach_point,
                                                  *m_geo);
         snapshot_state.pieces_left = state.pieces_left;
@@ -12,6 +12,7 @@
 #include "ColorMove.h"
 #include "Geometry.h"
 #include "MoveList.h"
+#include "PointBitSet.h"
 #include "PointList.h"
 #include "PointState.h"
 #include "Setup.h"
@@ -227,6 +228,10 @@ public:
 
     const GridExt<bool>& is_forbidden(Color c) const;
 
+    /** Same content as is_forbidden(Color) stored as a bit set.
+        Can be used for testing moves with get_move_mask(). */
+    const PointBitSet& get_forbidden_set(Color c) const;
+
     /** Check that no points of move are already occupied or adjacent to own
         color.
         Does not check if the move is diagonally adjacent to an existing
@@ -315,6 +320,8 @@ public:
 
     const MoveInfoExt2& get_move_info_ext_2(Move mv) const;
 
+    const MoveMask& get_move_mask(Move mv) const;
+
     bool is_colored_starting_point(Point p) const;
 
     bool is_colorless_starting_point(Point p) const;
@@ -338,6 +345,14 @@ public:
 
     Move get_move_at(Point p) const;
 
+    /** Get a hash code of the current position.
+        The hash code is a Zobrist hash of the point states, the number of
+        pieces left of each color, and the color to play. It is updated
+        incrementally and does not depend on the order of the moves that led
+        to the position.
+        @see BoardConst::get_zobrist() */
+    uint_least64_t get_hash() const;
+
     /** Remember the board state to quickly restore it later.
         A snapshot can only be restored from a position that was reached
         after playing moves from the snapshot position. */
@@ -346,6 +361,19 @@ public:
     /** See take_snapshot() */
     void restore_snapshot();
 
+    /** Restore the snapshot by rolling back only the points changed by the
+        moves played since the snapshot.
+        Faster than restore_snapshot() if only a few moves were played since
+        the snapshot because restore_snapshot() copies the state of all
+        points.
+        @see get_nu_moves_since_snapshot() */
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+    void restore_snapshot_delta();
+
+    /** Get the number of moves played since the snapshot.
+        @see take_snapshot() */
+    unsigned get_nu_moves_since_snapshot() const;
+
 private:
     /** Color-independent part of the board state. */
     struct StateBase
@@ -354,6 +382,9 @@ private:
 
         unsigned nu_onboard_pieces_all;
 
+        /** See get_hash(). Does not include the color to play. */
+        uint_least64_t hash;
+
         PointStateGrid point_state;
     };
 
@@ -362,6 +393,9 @@ private:
     {
         GridExt<bool> forbidden;
 
+        /** See get_forbidden_set() */
+        PointBitSet forbidden_set;
+
         Grid<bool> is_attach_point;
 
         PiecesLeftList pieces_left;
@@ -431,6 +465,12 @@ private:
     /** Caches m_bc->get_move_info_ext_2_array() */
     const MoveInfoExt2* m_move_info_ext_2_array;
 
+    /** Caches m_bc->get_move_mask_array() */
+    const MoveMask* m_move_mask_array;
+
+    /** Caches m_bc->get_zobrist_move_array() */
+    const uint_least64_t* m_zobrist_move_array;
+
     const Geometry* m_geo;
 
     /** See is_center_section(). */
@@ -475,6 +515,15 @@ private:
 
     void place_setup(const Setup& setup);
 
+    /** Restore the state of the points changed by place() from the
+        snapshot. */
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+    void restore_points(Color c, Move mv);
+
+    /** Restore the parts of the state that are not stored per point from the
+        snapshot. */
+    void restore_snapshot_counters();
+
     void write_pieces_left(ostream& out, Color c,
                            const PiecesLeftList& pieces_left, unsigned begin,
                            unsigned end) const;
@@ -529,11 +578,22 @@ inline BoardType Board::get_board_type() const
     return m_bc->get_board_type();
 }
 
+inline uint_least64_t Board::get_hash() const
+{
+    return m_state_base.hash ^ m_bc->get_zobrist_to_play(m_state_base.to_play);
+}
+
 inline ColorMove Board::get_move(unsigned n) const
 {
     return m_moves[n];
 }
 
+inline const MoveMask& Board::get_move_mask(Move mv) const
+{
+    LIBBOARDGAME_ASSERT(! mv.is_null());
+    return m_move_mask_array[mv.to_int()];
+}
+
 inline const MoveInfoExt2& Board::get_move_info_ext_2(Move mv) const
 {
     LIBBOARDGAME_ASSERT(! mv.is_null());
@@ -583,6 +643,12 @@ inline unsigned Board::get_nu_moves() const
     return m_moves.size();
 }
 
+inline unsigned Board::get_nu_moves_since_snapshot() const
+{
+    LIBBOARDGAME_ASSERT(m_snapshot.moves_size <= m_moves.size());
+    return m_moves.size() - m_snapshot.moves_size;
+}
+
 inline Color::IntType Board::get_nu_nonalt_colors() const
 {
     return m_variant != Variant::classic_3 ? m_nu_colors : 3;
@@ -758,6 +824,11 @@ inline bool Board::is_forbidden(Point p, Color c) const
     return m_state_color[c].forbidden[p];
 }
 
+inline const PointBitSet& Board::get_forbidden_set(Color c) const
+{
+    return m_state_color[c].forbidden_set;
+}
+
 inline const GridExt<bool>& Board::is_forbidden(Color c) const
 {
     return m_state_color[c].forbidden;
@@ -765,14 +836,7 @@ inline const GridExt<bool>& Board::is_forbidden(Color c) const
 
 inline bool Board::is_forbidden(Color c, Move mv) const
 {
-    auto points = get_move_points(mv);
-    auto i = points.begin();
-    auto end = points.end();
-    do
-        if (m_state_color[c].forbidden[*i])
-            return true;
-    while (++i != end);
-    return false;
+    return m_state_color[c].forbidden_set.intersects(get_move_mask(mv));
 }
 
 inline bool Board::is_legal(Move mv) const
@@ -798,7 +862,11 @@ inline void Board::place(Color c, Move mv)
     auto& state_color = m_state_color[c];
     LIBBOARDGAME_ASSERT(state_color.nu_left_piece[piece] > 0);
     auto score_points = m_score_points[piece];
-    if (--state_color.nu_left_piece[piece] == 0)
+    auto nu_left = --state_color.nu_left_piece[piece];
+    m_state_base.hash ^=
+            BoardConst::get_zobrist(mv, c, m_zobrist_move_array)
+            ^ m_bc->get_zobrist_piece(c, piece, nu_left);
+    if (nu_left == 0)
     {
         state_color.pieces_left.remove_fast(piece);
         if (MAX_SIZE == 22) // GembloQ
@@ -825,6 +893,7 @@ inline void Board::place(Color c, Move mv)
         m_state_base.point_state[*i] = PointState(c);
         for_each_color([&](Color c) {
             m_state_color[c].forbidden[*i] = true;
+            m_state_color[c].forbidden_set.set(*i);
         });
     }
     while (++i != end);
@@ -838,7 +907,10 @@ inline void Board::place(Color c, Move mv)
     {
         end = info_ext.end_adj();
         for (i = info_ext.begin_adj(); i != end; ++i)
+        {
             state_color.forbidden[*i] = true;
+            state_color.forbidden_set.set(*i);
+        }
         LIBBOARDGAME_ASSERT(i == info_ext.begin_attach());
         end += info_ext.size_attach_points;
     }
@@ -868,14 +940,39 @@ inline void Board::play(ColorMove mv)
     play(mv.color, mv.move);
 }
 
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+inline void Board::restore_points(Color c, Move mv)
+{
+    auto& info = BoardConst::get_move_info<MAX_SIZE>(mv, m_move_info_array);
+    auto& info_ext = BoardConst::get_move_info_ext<MAX_ADJ_ATTACH>(
+                mv, m_move_info_ext_array);
+    auto i = info.begin();
+    auto end = info.end();
+    do
+    {
+        m_state_base.point_state[*i] =
+                m_snapshot.state_base.point_state[*i];
+        for_each_color([&](Color c) {
+            m_state_color[c].forbidden[*i] =
+                    m_snapshot.state_color[c].forbidden[*i];
+        });
+    }
+    while (++i != end);
+    if (MAX_SIZE != 7) // Nexos has no adjacent points
+    {
+        auto& state_color = m_state_color[c];
+        auto& snapshot_state = m_snapshot.state_color[c];
+        end = info_ext.end_adj();
+        for (i = info_ext.begin_adj(); i != end; ++i)
+            state_color.forbidden[*i] = snapshot_state.forbidden[*i];
+    }
+}
+
 inline void Board::restore_snapshot()
 {
     LIBBOARDGAME_ASSERT(m_snapshot.moves_size <= m_moves.size());
     auto& geo = get_geometry();
     m_moves.resize(m_snapshot.moves_size);
-    m_state_base.to_play = m_snapshot.state_base.to_play;
-    m_state_base.nu_onboard_pieces_all =
-        m_snapshot.state_base.nu_onboard_pieces_all;
     m_state_base.point_state.memcpy_from(m_snapshot.state_base.point_state,
                                          geo);
     for (Color c : get_colors())
@@ -884,6 +981,22 @@ inline void Board::restore_snapshot()
         auto& state = m_state_color[c];
         state.forbidden.copy_from(snapshot_state.forbidden, geo);
         state.is_attach_point.copy_from(snapshot_state.is_attach_point, geo);
+    }
+    restore_snapshot_counters();
+}
+
+inline void Board::restore_snapshot_counters()
+{
+    auto& geo = get_geometry();
+    m_state_base.to_play = m_snapshot.state_base.to_play;
+    m_state_base.nu_onboard_pieces_all =
+        m_snapshot.state_base.nu_onboard_pieces_all;
+    m_state_base.hash = m_snapshot.state_base.hash;
+    for (Color c : get_colors())
+    {
+        const auto& snapshot_state = m_snapshot.state_color[c];
+        auto& state = m_state_color[c];
+        state.forbidden_set.copy_from(snapshot_state.forbidden_set, geo);
         state.pieces_left = snapshot_state.pieces_left;
         state.nu_left_piece = snapshot_state.nu_left_piece;
         state.nu_onboard_pieces = snapshot_state.nu_onboard_pieces;
@@ -892,6 +1005,29 @@ inline void Board::restore_snapshot()
     }
 }
 
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+inline void Board::restore_snapshot_delta()
+{
+    LIBBOARDGAME_ASSERT(m_snapshot.moves_size <= m_moves.size());
+    LIBBOARDGAME_ASSERT(m_max_piece_size == MAX_SIZE);
+    LIBBOARDGAME_ASSERT(m_max_adj_attach == MAX_ADJ_ATTACH);
+    for (auto i = m_moves.begin() + m_snapshot.moves_size; i != m_moves.end();
+         ++i)
+        restore_points<MAX_SIZE, MAX_ADJ_ATTACH>(i->color, i->move);
+    m_moves.resize(m_snapshot.moves_size);
+    // The attach points of the moves played since the snapshot were appended
+    // to the attach point lists
+    for (Color c : get_colors())
+    {
+        auto& attach_points = m_attach_points[c];
+        auto& is_attach_point = m_state_color[c].is_attach_point;
+        for (auto i = attach_points.begin() + m_snapshot.attach_points_size[c];
+             i != attach_points.end(); ++i)
+            is_attach_point[*i] = false;
+    }
+    restore_snapshot_counters();
+}
+
 inline void Board::set_to_play(Color c)
 {
     m_state_base.to_play = c;
@@ -7,6 +7,13 @@
 #include "BoardConst.h"
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <type_traits>
+#include <vector>
 #include "Marker.h"
 #include "PieceTransformsClassic.h"
 #include "PieceTransformsGembloQ.h"
@@ -24,6 +31,14 @@ namespace {
 
 const bool log_move_creation = false;
 
+/** Version of the format of the cache file.
+    Must be increased whenever the creation or the layout of the move tables
+    changes without changing the sizes of the data types. */
+const uint_least32_t cache_version = 1;
+
+/** See BoardConst::set_cache_dir() */
+string cache_dir;
+
 /** Local variable used during construction.
     Making this variable global slightly speeds up construction and a
     thread-safe construction is not needed. */
@@ -856,6 +871,8 @@ BoardConst::BoardConst(BoardType board_type, PieceSet piece_set)
         break;
     }
     ++m_range; // Move::null()
+    size_t move_info_size = 0;
+    size_t move_info_ext_size = 0;
     switch (piece_set)
     {
     case PieceSet::classic:
@@ -863,32 +880,32 @@ BoardConst::BoardConst(BoardType board_type, PieceSet piece_set)
         m_pieces = create_pieces_classic(m_geo, *m_transforms);
         m_max_piece_size = 5;
         m_max_adj_attach = 16;
-        m_move_info.reset(calloc(m_range, sizeof(MoveInfo<5>)));
-        m_move_info_ext.reset(calloc(m_range, sizeof(MoveInfoExt<16>)));
+        move_info_size = sizeof(MoveInfo<5>);
+        move_info_ext_size = sizeof(MoveInfoExt<16>);
         break;
     case PieceSet::junior:
         m_transforms = make_unique<PieceTransformsClassic>();
         m_pieces = create_pieces_junior(m_geo, *m_transforms);
         m_max_piece_size = 5;
         m_max_adj_attach = 16;
-        m_move_info.reset(calloc(m_range, sizeof(MoveInfo<5>)));
-        m_move_info_ext.reset(calloc(m_range, sizeof(MoveInfoExt<16>)));
+        move_info_size = sizeof(MoveInfo<5>);
+        move_info_ext_size = sizeof(MoveInfoExt<16>);
         break;
     case PieceSet::trigon:
         m_transforms = make_unique<PieceTransformsTrigon>();
         m_pieces = create_pieces_trigon(m_geo, *m_transforms);
         m_max_piece_size = 6;
         m_max_adj_attach = 22;
-        m_move_info.reset(calloc(m_range, sizeof(MoveInfo<6>)));
-        m_move_info_ext.reset(calloc(m_range, sizeof(MoveInfoExt<22>)));
+        move_info_size = sizeof(MoveInfo<6>);
+        move_info_ext_size = sizeof(MoveInfoExt<22>);
         break;
     case PieceSet::nexos:
         m_transforms = make_unique<PieceTransformsClassic>();
         m_pieces = create_pieces_nexos(m_geo, *m_transforms);
         m_max_piece_size = 7;
         m_max_adj_attach = 12;
-        m_move_info.reset(calloc(m_range, sizeof(MoveInfo<7>)));
-        m_move_info_ext.reset(calloc(m_range, sizeof(MoveInfoExt<12>)));
+        move_info_size = sizeof(MoveInfo<7>);
+        move_info_ext_size = sizeof(MoveInfoExt<12>);
         break;
     case PieceSet::callisto:
         m_transforms = make_unique<PieceTransformsClassic>();
@@ -899,19 +916,18 @@ BoardConst::BoardConst(BoardType board_type, PieceSet piece_set)
         // faster if we don't have to handle different values for
         // m_max_adj_attach for the same m_max_piece_size.
         m_max_adj_attach = 16;
-        m_move_info.reset(calloc(m_range, sizeof(MoveInfo<5>)));
-        m_move_info_ext.reset(calloc(m_range, sizeof(MoveInfoExt<16>)));
+        move_info_size = sizeof(MoveInfo<5>);
+        move_info_ext_size = sizeof(MoveInfoExt<16>);
         break;
     case PieceSet::gembloq:
         m_transforms = make_unique<PieceTransformsGembloQ>();
         m_pieces = create_pieces_gembloq(m_geo, *m_transforms);
         m_max_piece_size = 22;
         m_max_adj_attach = 44;
-        m_move_info.reset(calloc(m_range, sizeof(MoveInfo<22>)));
-        m_move_info_ext.reset(calloc(m_range, sizeof(MoveInfoExt<44>)));
+        move_info_size = sizeof(MoveInfo<22>);
+        move_info_ext_size = sizeof(MoveInfoExt<44>);
         break;
     }
-    m_move_info_ext_2 = make_unique<MoveInfoExt2[]>(m_range);
     m_nu_pieces = static_cast<Piece::IntType>(m_pieces.size());
     for (Point p : m_geo)
         if (has_adj_status_points(p))
@@ -921,7 +937,31 @@ BoardConst::BoardConst(BoardType board_type, PieceSet piece_set)
     for (Point p : m_geo)
         m_compare_val[p] =
                 (height - m_geo.get_y(p) - 1) * width + m_geo.get_x(p);
-    create_moves();
+    init_layout(move_info_size, move_info_ext_size);
+    string cache_path;
+    if (! cache_dir.empty())
+        cache_path = cache_dir + "/boardconst_"
+                + std::to_string(static_cast<int>(board_type)) + "_"
+                + std::to_string(static_cast<int>(piece_set)) + ".bin";
+    if (cache_path.empty() || ! load_cache(cache_path))
+    {
+        m_tables.reset(calloc(1, m_layout.size));
+        set_tables(m_tables.get());
+        create_moves();
+        if (board_type == BoardType::duo
+                || board_type == BoardType::callisto_2)
+            init_symmetry_info<5>();
+        else if (board_type == BoardType::trigon)
+            init_symmetry_info<6>();
+        else if (board_type == BoardType::gembloq_2)
+            init_symmetry_info<22>();
+        // Map the saved file, such that the memory is shared with other
+        // processes that use the cache
+        if (! cache_path.empty() && save_cache(cache_path)
+                && load_cache(cache_path))
+            m_tables.reset();
+    }
+    init_zobrist();
     switch (piece_set)
     {
     case PieceSet::classic:
@@ -943,12 +983,6 @@ BoardConst::BoardConst(BoardType board_type, PieceSet piece_set)
         LIBBOARDGAME_ASSERT(m_nu_pieces == 21);
         break;
     }
-    if (board_type == BoardType::duo || board_type == BoardType::callisto_2)
-        init_symmetry_info<5>();
-    else if (board_type == BoardType::trigon)
-        init_symmetry_info<6>();
-    else if (board_type == BoardType::gembloq_2)
-        init_symmetry_info<22>();
 }
 
 template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
@@ -960,14 +994,15 @@ inline void BoardConst::create_move(unsigned& moves_created, Piece piece,
     LIBBOARDGAME_ASSERT(moves_created < m_range);
     Move mv(static_cast<Move::IntType>(moves_created));
     void* place =
-            static_cast<MoveInfo<MAX_SIZE>*>(m_move_info.get())
-            + moves_created;
+            static_cast<MoveInfo<MAX_SIZE>*>(m_move_info) + moves_created;
     new(place) MoveInfo<MAX_SIZE>(piece, points);
     place =
-            static_cast<MoveInfoExt<MAX_ADJ_ATTACH>*>(m_move_info_ext.get())
+            static_cast<MoveInfoExt<MAX_ADJ_ATTACH>*>(m_move_info_ext)
             + moves_created;
     auto& info_ext = *new(place) MoveInfoExt<MAX_ADJ_ATTACH>();
     auto& info_ext_2 = m_move_info_ext_2[moves_created];
+    [[maybe_unused]] bool mask_fits = m_move_mask[moves_created].init(points);
+    LIBBOARDGAME_ASSERT(mask_fits);
     ++moves_created;
     auto scored_points = &info_ext_2.scored_points[0];
     for (auto p : points)
@@ -1035,7 +1070,12 @@ void BoardConst::create_moves()
     LIBBOARDGAME_ASSERT(Move::null().to_int() == 0);
     unsigned moves_created = 1;
 
-    unsigned n = 0;
+    // The move lists are created piece by piece but PrecompMoves needs them
+    // ordered by point, adjacent status and piece
+    auto nu_lists = m_geo.get_range() * PrecompMoves::nu_adj_status;
+    vector<Move> moves;
+    vector<uint_least32_t> list_begin(m_nu_pieces * nu_lists);
+    vector<uint_least8_t> list_size(m_nu_pieces * nu_lists);
     for (Piece::IntType i = 0; i < m_nu_pieces; ++i)
     {
         Piece piece(i);
@@ -1051,13 +1091,30 @@ void BoardConst::create_moves()
             for (unsigned j = 0; j < PrecompMoves::nu_adj_status; ++j)
                 {
                     auto& list = g_full_move_table[p][j];
-                    m_precomp_moves.set_list_range(p, j, piece, n,
-                                                   list.size());
-                    for (auto mv : list)
-                        m_precomp_moves.set_move(n++, mv);
+                    auto k = i * nu_lists
+                            + p.to_int() * PrecompMoves::nu_adj_status + j;
+                    list_begin[k] = static_cast<uint_least32_t>(moves.size());
+                    list_size[k] = static_cast<uint_least8_t>(list.size());
+                    moves.insert(moves.end(), list.begin(), list.end());
                     list.clear();
                 }
     }
+    unsigned n = 0;
+    for (Point p : m_geo)
+    {
+        auto point_begin = n;
+        for (unsigned j = 0; j < PrecompMoves::nu_adj_status; ++j)
+            for (Piece::IntType i = 0; i < m_nu_pieces; ++i)
+            {
+                auto k = i * nu_lists
+                        + p.to_int() * PrecompMoves::nu_adj_status + j;
+                m_precomp_moves->set_list_range(p, j, Piece(i),
+                                                n - point_begin, list_size[k]);
+                for (unsigned l = 0; l < list_size[k]; ++l)
+                    m_precomp_moves->set_move(n++, moves[list_begin[k] + l]);
+            }
+        m_precomp_moves->set_point_begin(p, point_begin);
+    }
     LIBBOARDGAME_ASSERT(moves_created == m_range);
     LIBBOARDGAME_LOG("Created moves: ", moves_created, ", precomp: ", n);
 }
@@ -1163,6 +1220,8 @@ bool BoardConst::from_string(Move& mv, const string& s) const
 const BoardConst& BoardConst::get(Variant variant)
 {
     static map<BoardType, map<PieceSet, unique_ptr<BoardConst>>> board_const;
+    static mutex board_const_mutex;
+    lock_guard lock(board_const_mutex);
     auto board_type = libpentobi_base::get_board_type(variant);
     auto piece_set = libpentobi_base::get_piece_set(variant);
     auto& bc = board_const[board_type][piece_set];
@@ -1171,6 +1230,27 @@ const BoardConst& BoardConst::get(Variant variant)
     return *bc;
 }
 
+auto BoardConst::get_cache_header() const -> CacheHeader
+{
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "PNTBCNST", sizeof(header.magic));
+    header.version = cache_version;
+    header.byte_order = 0x01020304;
+    header.board_type = static_cast<uint_least32_t>(m_board_type);
+    header.piece_set = static_cast<uint_least32_t>(m_piece_set);
+    header.range = m_range;
+    header.move_info_size =
+            static_cast<uint_least32_t>(m_layout.move_info_size);
+    header.move_info_ext_size =
+            static_cast<uint_least32_t>(m_layout.move_info_ext_size);
+    header.move_info_ext_2_size = sizeof(MoveInfoExt2);
+    header.move_mask_size = sizeof(MoveMask);
+    header.precomp_moves_size = sizeof(PrecompMoves);
+    header.size = static_cast<uint_least32_t>(m_layout.size);
+    return header;
+}
+
 Piece BoardConst::get_move_piece(Move mv) const
 {
     if (m_max_piece_size == 5)
@@ -1289,6 +1369,36 @@ void BoardConst::init_adj_status_points(Point p)
     LIBBOARDGAME_ASSERT(n == max_size);
 }
 
+void BoardConst::init_layout(size_t move_info_size,
+                             size_t move_info_ext_size)
+{
+    // The tables are copied to and from the memory block with memcpy
+    static_assert(is_trivially_copyable_v<MoveInfoExt2>);
+    static_assert(is_trivially_copyable_v<MoveMask>);
+    static_assert(is_trivially_copyable_v<PrecompMoves>);
+    static_assert(is_trivially_copyable_v<SymmetricPoints>);
+    // Start each table at a cache line
+    auto align = [](size_t n) { return (n + 63) / 64 * 64; };
+    m_layout.move_info_size = move_info_size;
+    m_layout.move_info_ext_size = move_info_ext_size;
+    size_t n = align(sizeof(CacheHeader));
+    m_layout.move_info = n;
+    n = align(n + m_range * move_info_size);
+    m_layout.move_info_ext = n;
+    n = align(n + m_range * move_info_ext_size);
+    m_layout.move_info_ext_2 = n;
+    n = align(n + m_range * sizeof(MoveInfoExt2));
+    m_layout.move_mask = n;
+    n = align(n + m_range * sizeof(MoveMask));
+    m_layout.precomp_moves = n;
+    n = align(n + sizeof(PrecompMoves));
+    m_layout.nu_attach_points = n;
+    n = align(n + sizeof(m_nu_attach_points));
+    m_layout.symmetric_points = n;
+    n = align(n + sizeof(m_symmetric_points));
+    m_layout.size = n;
+}
+
 template<unsigned MAX_SIZE>
 void BoardConst::init_symmetry_info()
 {
@@ -1319,6 +1429,106 @@ void BoardConst::init_symmetry_info()
     }
 }
 
+void BoardConst::init_zobrist()
+{
+    // Fixed seed to get reproducible hash codes
+    mt19937_64 generator;
+    for (Point p : m_geo)
+        m_zobrist_point[p] = generator();
+    m_zobrist_move = make_unique<uint_least64_t[]>(m_range);
+    m_zobrist_move[0] = 0;
+    for (Move::IntType i = 1; i < m_range; ++i)
+    {
+        uint_least64_t key = 0;
+        for (Point p : get_move_points(Move(i)))
+            key ^= m_zobrist_point[p];
+        m_zobrist_move[i] = key;
+    }
+    for (Color::IntType i = 0; i < Color::range; ++i)
+    {
+        Color c(i);
+        for (Piece::IntType j = 0; j < m_nu_pieces; ++j)
+            for (auto& key : m_zobrist_piece[c][Piece(j)])
+                key = generator();
+        m_zobrist_to_play[c] = generator();
+    }
+}
+
+bool BoardConst::load_cache(const string& path)
+{
+    if (! m_cache_file.open(path))
+        return false;
+    auto header = get_cache_header();
+    if (m_cache_file.get_size() != m_layout.size
+            || memcmp(m_cache_file.get_data(), &header, sizeof(header)) != 0)
+    {
+        LIBBOARDGAME_LOG("Ignoring incompatible cache file ", path);
+        m_cache_file.close();
+        return false;
+    }
+    // The tables are never modified after the construction, so we can point
+    // into the read-only mapping
+    auto data = const_cast<void*>(m_cache_file.get_data());
+    set_tables(data);
+    auto bytes = static_cast<const char*>(data);
+    memcpy(&m_nu_attach_points, bytes + m_layout.nu_attach_points,
+           sizeof(m_nu_attach_points));
+    memcpy(&m_symmetric_points, bytes + m_layout.symmetric_points,
+           sizeof(m_symmetric_points));
+    LIBBOARDGAME_LOG("Mapped moves from ", path);
+    return true;
+}
+
+bool BoardConst::save_cache(const string& path)
+{
+    LIBBOARDGAME_ASSERT(m_tables);
+    auto bytes = static_cast<char*>(m_tables.get());
+    auto header = get_cache_header();
+    memcpy(bytes, &header, sizeof(header));
+    memcpy(bytes + m_layout.nu_attach_points, &m_nu_attach_points,
+           sizeof(m_nu_attach_points));
+    memcpy(bytes + m_layout.symmetric_points, &m_symmetric_points,
+           sizeof(m_symmetric_points));
+    // Write to a temporary file and rename it, such that other processes
+    // never map a partially written file
+    auto tmp_path = path + ".tmp" + std::to_string(random_device()());
+    {
+        ofstream out(tmp_path, ios::binary);
+        out.write(bytes, static_cast<streamsize>(m_layout.size));
+        if (! out)
+        {
+            LIBBOARDGAME_LOG("Could not write ", tmp_path);
+            out.close();
+            remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        LIBBOARDGAME_LOG("Could not rename ", tmp_path, " to ", path);
+        remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BoardConst::set_cache_dir(const string& dir)
+{
+    cache_dir = dir;
+}
+
+void BoardConst::set_tables(void* tables)
+{
+    auto bytes = static_cast<char*>(tables);
+    m_move_info = bytes + m_layout.move_info;
+    m_move_info_ext = bytes + m_layout.move_info_ext;
+    m_move_info_ext_2 =
+            reinterpret_cast<MoveInfoExt2*>(bytes + m_layout.move_info_ext_2);
+    m_move_mask = reinterpret_cast<MoveMask*>(bytes + m_layout.move_mask);
+    m_precomp_moves =
+            reinterpret_cast<PrecompMoves*>(bytes + m_layout.precomp_moves);
+}
+
 void BoardConst::sort(MovePoints& points) const
 {
     auto less = [this](Point a, Point b)
@@ -7,15 +7,19 @@
 #ifndef LIBPENTOBI_BASE_BOARD_CONST_H
 #define LIBPENTOBI_BASE_BOARD_CONST_H
 
+#include "ColorMap.h"
 #include "MoveInfo.h"
 #include "PieceInfo.h"
+#include "PointBitSet.h"
 #include "PrecompMoves.h"
 #include "SymmetricPoints.h"
 #include "Variant.h"
+#include "libboardgame_base/MappedFile.h"
 #include "libboardgame_base/Range.h"
 
 namespace libpentobi_base {
 
+using libboardgame_base::MappedFile;
 using libboardgame_base::Range;
 
 //-----------------------------------------------------------------------------
@@ -41,9 +45,31 @@ public:
 
     /** Get the single instance for a given board size.
         The instance is created the first time this function is called.
-        This function is not thread-safe. */
+        This function is thread-safe, such that boards in different threads
+        (e.g. in concurrent self-play games) share the same instance. */
     static const BoardConst& get(Variant variant);
 
+    /** Create an instance that is not shared.
+        Should only be used for testing the cache, all other code should use
+        get(). */
+    BoardConst(BoardType board_type, PieceSet piece_set);
+
+    /** Set a directory for caching the move tables.
+        If set, the move tables (move infos, move masks and precomputed move
+        lists) of a board type and piece set are written to a binary file in
+        this directory after they were created and mapped read-only from this
+        file in later processes. Processes that map the same file share its
+        physical memory and don't need to create the tables again. The file
+        contains a header with a format version and the sizes of the data
+        types; it is ignored and replaced if the header does not match. An
+        empty string (the default) disables the cache. Must be called before
+        the first call of get() to have an effect on all instances.
+        The cache is only supported on systems supported by MappedFile. */
+    static void set_cache_dir(const string& dir);
+
+    /** Were the move tables mapped from a cache file? */
+    bool is_mapped() const { return m_cache_file.is_open(); }
+
     template<unsigned MAX_SIZE>
     static const MoveInfo<MAX_SIZE>&
     get_move_info(Move mv, MoveInfoArray move_info_array);
@@ -83,7 +109,7 @@ public:
     template<unsigned MAX_SIZE>
     Piece get_move_piece(Move mv) const;
 
-    MoveInfoArray get_move_info_array() const { return m_move_info.get(); }
+    MoveInfoArray get_move_info_array() const { return m_move_info; }
 
     /** Get pointer to extended move info array.
         Can be used to speed up the access to the move info by avoiding the
@@ -94,6 +120,12 @@ public:
 
     const MoveInfoExt2* get_move_info_ext_2_array() const;
 
+    /** Get the bit mask of the points of a move.
+        Contains the same points as get_move_points(). */
+    const MoveMask& get_move_mask(Move mv) const;
+
+    const MoveMask* get_move_mask_array() const { return m_move_mask; }
+
     Move::IntType get_range() const { return m_range; }
 
     bool find_move(const MovePoints& points, Move& move) const;
@@ -105,10 +137,13 @@ public:
     PrecompMoves::Range get_moves(Piece piece, Point p,
                                   unsigned adj_status = 0) const
     {
-        return m_precomp_moves.get_moves(piece, p, adj_status);
+        return m_precomp_moves->get_moves(piece, p, adj_status);
     }
 
-    const PrecompMoves& get_precomp_moves() const { return m_precomp_moves; }
+    const PrecompMoves& get_precomp_moves() const
+    {
+        return *m_precomp_moves;
+    }
 
     BoardType get_board_type() const { return m_board_type; }
 
@@ -152,12 +187,102 @@ public:
     /** Sort move points using the ordering used in blksgf files. */
     void sort(MovePoints& points) const;
 
+    /** @name Zobrist hashing
+        Random keys for computing a hash code of a board position
+        incrementally. The keys are generated with a fixed seed, so that hash
+        codes are reproducible. The key of a point for a color is the key of
+        the point rotated by 16 bits per color index, which allows to
+        precompute the combined key of the points of a move only once for
+        all colors. */
+    /** @{ */
+
+    uint_least64_t get_zobrist(Point p, Color c) const;
+
+    /** Combined key of the points of a move.
+        Equal to the XOR of get_zobrist(Point,Color) for all points of the
+        move. */
+    uint_least64_t get_zobrist(Move mv, Color c) const;
+
+    /** Start of the array with the combined keys of the points of a move
+        for Color(0), which can be cached by the user in performance-critical
+        code and then passed into the static version of get_zobrist(). */
+    const uint_least64_t* get_zobrist_move_array() const;
+
+    static uint_least64_t get_zobrist(Move mv, Color c,
+                                      const uint_least64_t* zobrist_move_array);
+
+    /** Key for a piece of a color that has a given number of instances
+        left. */
+    uint_least64_t get_zobrist_piece(Color c, Piece piece,
+                                     unsigned nu_left) const;
+
+    uint_least64_t get_zobrist_to_play(Color c) const;
+
+    /** @} */ // @name
+
 private:
     struct MallocFree
     {
         void operator()(void* x) { free(x); }
     };
 
+    /** Header of the cache file.
+        The file is only used if all fields match the values expected by the
+        current process. */
+    struct CacheHeader
+    {
+        char magic[8];
+
+        uint_least32_t version;
+
+        /** Detects files written on a system with a different byte order. */
+        uint_least32_t byte_order;
+
+        uint_least32_t board_type;
+
+        uint_least32_t piece_set;
+
+        uint_least32_t range;
+
+        uint_least32_t move_info_size;
+
+        uint_least32_t move_info_ext_size;
+
+        uint_least32_t move_info_ext_2_size;
+
+        uint_least32_t move_mask_size;
+
+        uint_least32_t precomp_moves_size;
+
+        uint_least32_t size;
+    };
+
+    /** Offsets of the move tables in a single block of memory.
+        The block starts with a CacheHeader, such that it can be written to a
+        cache file and mapped from it without conversion. */
+    struct TableLayout
+    {
+        size_t move_info_size;
+
+        size_t move_info_ext_size;
+
+        size_t move_info;
+
+        size_t move_info_ext;
+
+        size_t move_info_ext_2;
+
+        size_t move_mask;
+
+        size_t precomp_moves;
+
+        size_t nu_attach_points;
+
+        size_t symmetric_points;
+
+        size_t size;
+    };
+
 
     Piece::IntType m_nu_pieces;
 
@@ -182,20 +307,36 @@ private:
 
     PieceMap<unsigned> m_nu_attach_points{0};
 
+    TableLayout m_layout;
+
+    /** Memory block with the move tables if they were created by this
+        instance. */
+    unique_ptr<void, MallocFree> m_tables;
+
+    /** Mapped cache file with the move tables if they were loaded from the
+        cache. */
+    MappedFile m_cache_file;
+
+    // The following pointers point into m_tables or into the read-only
+    // memory of m_cache_file and must not be used for modifying the tables
+    // after the construction
+
     /** Array of MoveInfo<MAX_SIZE> with MAX_SIZE being the maximum piece size
         in the corresponding game variant.
         See comments at MoveInfo. */
-    unique_ptr<void, MallocFree> m_move_info;
+    void* m_move_info;
 
     /** Array of MoveInfoExt<MAX_ADJ_ATTACH> with MAX_ADJ_ATTACH being the
         maximum total number of attach points and adjacent points of a piece in
         the corresponding game variant.
         See comments at MoveInfoExt. */
-    unique_ptr<void, MallocFree> m_move_info_ext;
+    void* m_move_info_ext;
+
+    MoveInfoExt2* m_move_info_ext_2;
 
-    unique_ptr<MoveInfoExt2[]> m_move_info_ext_2;
+    MoveMask* m_move_mask;
 
-    PrecompMoves m_precomp_moves;
+    PrecompMoves* m_precomp_moves;
 
     /** Value for comparing points using the ordering used in blksgf files.
         As specified in doc/blksgf/Pentobi-SGF.html, the order should be
@@ -205,8 +346,16 @@ private:
 
     SymmetricPoints m_symmetric_points;
 
+    Grid<uint_least64_t> m_zobrist_point;
+
+    /** See get_zobrist_move_array() */
+    unique_ptr<uint_least64_t[]> m_zobrist_move;
+
+    ColorMap<PieceMap<array<uint_least64_t, PieceInfo::max_instances>>>
+    m_zobrist_piece;
+
+    ColorMap<uint_least64_t> m_zobrist_to_play;
 
-    BoardConst(BoardType board_type, PieceSet piece_set);
 
     template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
     void create_move(unsigned& moves_created, Piece piece,
@@ -217,13 +366,25 @@ private:
     template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
     void create_moves(unsigned& moves_created, Piece piece);
 
+    CacheHeader get_cache_header() const;
+
     template<unsigned MAX_SIZE>
     const MoveInfo<MAX_SIZE>& get_move_info(Move mv) const;
 
     void init_adj_status_points(Point p);
 
+    void init_layout(size_t move_info_size, size_t move_info_ext_size);
+
     template<unsigned MAX_SIZE>
     void init_symmetry_info();
+
+    void init_zobrist();
+
+    bool load_cache(const string& path);
+
+    bool save_cache(const string& path);
+
+    void set_tables(void* tables);
 };
 
 inline const Geometry& BoardConst::get_geometry() const
@@ -244,7 +405,7 @@ template<unsigned MAX_SIZE>
 inline const MoveInfo<MAX_SIZE>& BoardConst::get_move_info(Move mv) const
 {
     LIBBOARDGAME_ASSERT(m_max_piece_size == MAX_SIZE);
-    return get_move_info<MAX_SIZE>(mv, m_move_info.get());
+    return get_move_info<MAX_SIZE>(mv, m_move_info);
 }
 
 template<unsigned MAX_ADJ_ATTACH>
@@ -264,12 +425,19 @@ inline const MoveInfoExt2& BoardConst::get_move_info_ext_2(Move mv) const
 
 inline auto BoardConst::get_move_info_ext_array() const -> MoveInfoExtArray
 {
-    return m_move_info_ext.get();
+    return m_move_info_ext;
+}
+
+inline const MoveMask& BoardConst::get_move_mask(Move mv) const
+{
+    LIBBOARDGAME_ASSERT(! mv.is_null());
+    LIBBOARDGAME_ASSERT(mv.to_int() < m_range);
+    return m_move_mask[mv.to_int()];
 }
 
 inline const MoveInfoExt2* BoardConst::get_move_info_ext_2_array() const
 {
-    return m_move_info_ext_2.get();
+    return m_move_info_ext_2;
 }
 
 template<unsigned MAX_SIZE>
@@ -339,6 +507,45 @@ inline const PieceTransforms& BoardConst::get_transforms() const
     return *m_transforms;
 }
 
+inline uint_least64_t BoardConst::get_zobrist(Point p, Color c) const
+{
+    auto key = m_zobrist_point[p];
+    auto shift = 16 * c.to_int();
+    return shift == 0 ? key : (key << shift) | (key >> (64 - shift));
+}
+
+inline uint_least64_t BoardConst::get_zobrist(
+        Move mv, Color c, const uint_least64_t* zobrist_move_array)
+{
+    LIBBOARDGAME_ASSERT(! mv.is_null());
+    auto key = zobrist_move_array[mv.to_int()];
+    auto shift = 16 * c.to_int();
+    return shift == 0 ? key : (key << shift) | (key >> (64 - shift));
+}
+
+inline uint_least64_t BoardConst::get_zobrist(Move mv, Color c) const
+{
+    LIBBOARDGAME_ASSERT(mv.to_int() < m_range);
+    return get_zobrist(mv, c, m_zobrist_move.get());
+}
+
+inline const uint_least64_t* BoardConst::get_zobrist_move_array() const
+{
+    return m_zobrist_move.get();
+}
+
+inline uint_least64_t BoardConst::get_zobrist_piece(Color c, Piece piece,
+                                                    unsigned nu_left) const
+{
+    LIBBOARDGAME_ASSERT(nu_left < PieceInfo::max_instances);
+    return m_zobrist_piece[c][piece][nu_left];
+}
+
+inline uint_least64_t BoardConst::get_zobrist_to_play(Color c) const
+{
+    return m_zobrist_to_play[c];
+}
+
 //-----------------------------------------------------------------------------
 
 } // namespace libpentobi_base
@@ -35,6 +35,8 @@ public:
 
     Move genmove(const Board& bd, Color c);
 
+    void set_seed(RandomGenerator::ResultType seed);
+
     const PentobiTree& get_tree() const;
 
 private:
@@ -63,6 +65,11 @@ inline const PentobiTree& Book::get_tree() const
     return m_tree;
 }
 
+inline void Book::set_seed(RandomGenerator::ResultType seed)
+{
+    m_random.set_seed(seed);
+}
+
 //-----------------------------------------------------------------------------
 
 } // namespace libpentobi_base
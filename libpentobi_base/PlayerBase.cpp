@@ -10,11 +10,28 @@ namespace libpentobi_base {
 
 //-----------------------------------------------------------------------------
 
+void PlayerBase::prepare_followup([[maybe_unused]] const Board& bd,
+                                  [[maybe_unused]] Color c)
+{
+    // Default implementation does nothing
+}
+
 bool PlayerBase::resign() const
 {
     return false;
 }
 
+void PlayerBase::start_ponder([[maybe_unused]] const Board& bd,
+                              [[maybe_unused]] Color c)
+{
+    // Default implementation does nothing
+}
+
+void PlayerBase::stop_ponder()
+{
+    // Default implementation does nothing
+}
+
 //-----------------------------------------------------------------------------
 
 } // namespace libpentobi_base
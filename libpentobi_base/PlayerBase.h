@@ -20,6 +20,32 @@ public:
 
     virtual Move genmove(const Board& bd, Color c) = 0;
 
+    /** Inform the player about a new position, in which it will probably
+        have to generate a move.
+        This can be called after moves were played on the board, so that the
+        player can prepare the next genmove() while waiting for the next
+        command. The default implementation does nothing.
+        @param bd The board. Must not be modified until the function
+        returns.
+        @param c The color that will probably be asked to move. */
+    virtual void prepare_followup(const Board& bd, Color c);
+
+    /** Start thinking about a position in the background.
+        This is similar to prepare_followup() but the player continues to
+        think until stop_ponder() is called, such that the next genmove() in
+        this or a follow-up position can reuse the result. The default
+        implementation does nothing.
+        @param bd The board. The player makes a copy of the board, so it
+        can be modified after the function returns.
+        @param c The color that will probably be asked to move. */
+    virtual void start_ponder(const Board& bd, Color c);
+
+    /** Stop thinking in the background.
+        Must be called before calling any other functions of the player if
+        start_ponder() was called. Returns immediately if the player is not
+        pondering. The default implementation does nothing. */
+    virtual void stop_ponder();
+
     /** Check if the player wants to resign.
         This may only be called after a genmove() and returns true if the
         player wants to resign in the position at the last genmove().
@@ -0,0 +1,161 @@
+//-----------------------------------------------------------------------------
+/** @file libpentobi_base/PointBitSet.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBPENTOBI_BASE_POINT_BIT_SET_H
+#define LIBPENTOBI_BASE_POINT_BIT_SET_H
+
+#include <algorithm>
+#include <cstdint>
+#include "Geometry.h"
+
+namespace libpentobi_base {
+
+//-----------------------------------------------------------------------------
+
+/** Bit mask of the points of a move.
+    The mask consists of max_words consecutive words of a PointBitSet
+    starting at first_word. The points of a move are close to each other in
+    the point numbering, which uses rows of the board, so the mask covers
+    the points of all moves in all game variants (the moves of the largest
+    pieces in GembloQ span 6 words, the moves in all other game variants at
+    most 3 words). */
+struct MoveMask
+{
+    static constexpr unsigned max_words = 6;
+
+    uint_least64_t bits[max_words];
+
+    uint_least16_t first_word;
+
+    /** Initialize the mask.
+        @param points A container of points.
+        @return false if the points do not fit into the mask. */
+    template<class T>
+    bool init(const T& points);
+};
+
+//-----------------------------------------------------------------------------
+
+/** Set of points stored as bits.
+    Used in addition to a Grid<bool> if whole moves need to be tested against
+    the set, which needs only a few word operations with a MoveMask. The
+    words beyond the range of the geometry are always zero. */
+class PointBitSet
+{
+public:
+    static constexpr unsigned word_bits = 64;
+
+    static constexpr unsigned nu_words =
+            (Point::range_onboard + word_bits - 1) / word_bits;
+
+    static_assert(nu_words >= MoveMask::max_words);
+
+    static unsigned get_nu_words(const Geometry& geo);
+
+    bool operator[](Point p) const;
+
+    void set(Point p);
+
+    /** Remove all points. */
+    void clear();
+
+    bool empty() const;
+
+    /** Copy the words used by a geometry. */
+    void copy_from(const PointBitSet& set, const Geometry& geo);
+
+    /** Set to the points of set1 that are not contained in set2. */
+    void set_difference(const PointBitSet& set1, const PointBitSet& set2);
+
+    /** Check if the set contains any point of a move. */
+    bool intersects(const MoveMask& mask) const;
+
+    uint_least64_t get_word(unsigned i) const { return m_words[i]; }
+
+private:
+    uint_least64_t m_words[nu_words];
+};
+
+inline bool PointBitSet::operator[](Point p) const
+{
+    LIBBOARDGAME_ASSERT(! p.is_null());
+    auto i = p.to_int();
+    return (m_words[i / word_bits] >> (i % word_bits)) & 1;
+}
+
+inline void PointBitSet::clear()
+{
+    fill(m_words, m_words + nu_words, 0);
+}
+
+inline void PointBitSet::copy_from(const PointBitSet& set,
+                                   const Geometry& geo)
+{
+    copy(set.m_words, set.m_words + get_nu_words(geo), m_words);
+}
+
+inline bool PointBitSet::empty() const
+{
+    return all_of(m_words, m_words + nu_words,
+                  [](uint_least64_t w) { return w == 0; });
+}
+
+inline unsigned PointBitSet::get_nu_words(const Geometry& geo)
+{
+    return (geo.get_range() + word_bits - 1) / word_bits;
+}
+
+inline bool PointBitSet::intersects(const MoveMask& mask) const
+{
+    static_assert(MoveMask::max_words == 6);
+    auto words = m_words + mask.first_word;
+    return ((words[0] & mask.bits[0]) | (words[1] & mask.bits[1])
+            | (words[2] & mask.bits[2]) | (words[3] & mask.bits[3])
+            | (words[4] & mask.bits[4]) | (words[5] & mask.bits[5])) != 0;
+}
+
+inline void PointBitSet::set(Point p)
+{
+    LIBBOARDGAME_ASSERT(! p.is_null());
+    auto i = p.to_int();
+    m_words[i / word_bits] |= uint_least64_t(1) << (i % word_bits);
+}
+
+inline void PointBitSet::set_difference(const PointBitSet& set1,
+                                        const PointBitSet& set2)
+{
+    for (unsigned i = 0; i < nu_words; ++i)
+        m_words[i] = set1.m_words[i] & ~set2.m_words[i];
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T>
+bool MoveMask::init(const T& points)
+{
+    fill(bits, bits + max_words, 0);
+    unsigned min_word = PointBitSet::nu_words;
+    for (auto p : points)
+        min_word = min(min_word, p.to_int() / PointBitSet::word_bits);
+    // Words behind the end of PointBitSet cannot be accessed
+    first_word = static_cast<uint_least16_t>(
+                min(min_word, PointBitSet::nu_words - max_words));
+    for (auto p : points)
+    {
+        auto i = p.to_int() - first_word * PointBitSet::word_bits;
+        if (i >= max_words * PointBitSet::word_bits)
+            return false;
+        bits[i / PointBitSet::word_bits] |=
+                uint_least64_t(1) << (i % PointBitSet::word_bits);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libpentobi_base
+
+#endif // LIBPENTOBI_BASE_POINT_BIT_SET_H
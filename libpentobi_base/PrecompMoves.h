@@ -22,6 +22,13 @@ namespace libpentobi_base {
     all moves that include a given point constrained by the piece type and the
     forbidden status of adjacant points. This drastically reduces the number of
     moves that need to be checked for legality during move generation.
+    The lists are stored ordered by point, adjacent status and piece, which is
+    the order in which they are accessed during move generation. This allows
+    to store the beginning of a list as a 16-bit offset to the beginning of
+    the lists at the point. The sizes of the lists, which are needed for
+    checking if a piece has moves at all, are stored separately from the
+    offsets, such that the sizes for all pieces at a point and adjacent status
+    fit into a single cache line.
     @see Board::get_adj_status() */
 class PrecompMoves
 {
@@ -61,25 +68,56 @@ public:
         m_move_lists[i] = mv;
     }
 
-    /** Store beginning and end of a local move list duing construction. */
+    /** Store the beginning of the lists at a point during construction.
+        The beginning of each list at the point is stored relative to this
+        value (see set_list_range()). During an in-place construction, it must
+        be called after all lists of the point were read because it changes
+        the result of get_moves() for the lists not yet stored. */
+    void set_point_begin(Point p, unsigned begin)
+    {
+        LIBBOARDGAME_ASSERT(begin <= max_move_lists_sum_length);
+        m_point_begin[p] = begin;
+    }
+
+    /** Store beginning and size of a local move list during construction.
+        @param p
+        @param adj_status
+        @param piece
+        @param offset The beginning of the list relative to the beginning of
+        the lists at the point that will be passed to set_point_begin().
+        @param size */
     void set_list_range(Point p, unsigned adj_status, Piece piece,
-                        unsigned begin, unsigned size)
+                        unsigned offset, unsigned size)
+    {
+        LIBBOARDGAME_ASSERT(offset < (1 << 16));
+        LIBBOARDGAME_ASSERT(size < (1 << 8));
+        m_list_offset[p][adj_status][piece] =
+                static_cast<uint_least16_t>(offset);
+        m_list_size[p][adj_status][piece] = static_cast<uint_least8_t>(size);
+    }
+
+    /** Shrink a local move list.
+        Used for removing moves from a list in place in follow-up positions,
+        which leaves the beginning of the list unchanged. */
+    void set_list_size(Point p, unsigned adj_status, Piece piece,
+                       unsigned size)
     {
-        m_moves_range[p][adj_status][piece] = CompressedRange(begin, size);
+        LIBBOARDGAME_ASSERT(size <= m_list_size[p][adj_status][piece]);
+        m_list_size[p][adj_status][piece] = static_cast<uint_least8_t>(size);
     }
 
     /** Get all moves of a piece at a point constrained by the forbidden
         status of adjacent points. */
     Range get_moves(Piece piece, Point p, unsigned adj_status = 0) const
     {
-        auto& range = m_moves_range[p][adj_status][piece];
-        auto begin = move_lists_begin() + range.begin();
-        return {begin, begin + range.size()};
+        auto begin = move_lists_begin() + m_point_begin[p]
+                + m_list_offset[p][adj_status][piece];
+        return {begin, begin + m_list_size[p][adj_status][piece]};
     }
 
     bool has_moves(Piece piece, Point p, unsigned adj_status) const
     {
-        return ! m_moves_range[p][adj_status][piece].empty();
+        return m_list_size[p][adj_status][piece] != 0;
     }
 
     /** Begin of storage for move lists.
@@ -91,38 +129,22 @@ public:
     const Move* move_lists_begin() const { return &(*m_move_lists.begin()); }
 
 private:
-    class CompressedRange
-    {
-    public:
-        CompressedRange() = default;
-
-        CompressedRange(unsigned begin, unsigned size)
-        {
-            LIBBOARDGAME_ASSERT(begin + size <= max_move_lists_sum_length);
-            static_assert(max_move_lists_sum_length < (1 << 24));
-            LIBBOARDGAME_ASSERT(size < (1 << 8));
-            m_val = size;
-            if (size != 0)
-                m_val |= (begin << 8);
-        }
-
-        bool empty() const { return m_val == 0; }
-
-        unsigned begin() const { return m_val >> 8; }
-
-        unsigned size() const { return m_val & 0xff; }
+    /** Sizes of the move lists.
+        Stored separately from m_list_offset because has_moves() is called
+        much more often than get_moves(). */
+    Grid<array<PieceMap<uint_least8_t>, nu_adj_status>> m_list_size;
 
-    private:
-        uint_least32_t m_val;
-    };
+    /** Beginning of the move lists relative to m_point_begin. */
+    Grid<array<PieceMap<uint_least16_t>, nu_adj_status>> m_list_offset;
 
-    /** See m_move_lists. */
-    Grid<array<PieceMap<CompressedRange>, nu_adj_status>> m_moves_range;
+    /** Index of the beginning of the move lists at a point. */
+    Grid<uint_least32_t> m_point_begin;
 
     /** Compact representation of lists of moves of a piece at a point
         constrained by the forbidden status of adjacent points.
-        All lists are stored in a single array; m_moves_range contains
-        information about the actual begin/end indices. */
+        All lists are stored in a single array; m_point_begin, m_list_offset
+        and m_list_size contain information about the actual begin/end
+        indices. */
     array<Move, max_move_lists_sum_length> m_move_lists;
 };
 
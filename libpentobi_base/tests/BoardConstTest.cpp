@@ -6,6 +6,9 @@
 
 #include "libpentobi_base/BoardConst.h"
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include "libboardgame_test/Test.h"
 
 using namespace std;
@@ -13,6 +16,122 @@ using namespace libpentobi_base;
 
 //-----------------------------------------------------------------------------
 
+namespace {
+
+/** Check that two instances have the same move tables. */
+void check_equal_tables(const BoardConst& bc1, const BoardConst& bc2)
+{
+    LIBBOARDGAME_CHECK_EQUAL(bc1.get_range(), bc2.get_range());
+    LIBBOARDGAME_CHECK_EQUAL(bc1.get_nu_pieces(), bc2.get_nu_pieces());
+    for (Move::IntType i = 1; i < bc1.get_range(); ++i)
+    {
+        Move mv(i);
+        LIBBOARDGAME_CHECK(bc1.get_move_piece(mv) == bc2.get_move_piece(mv));
+        auto points1 = bc1.get_move_points(mv);
+        auto points2 = bc2.get_move_points(mv);
+        LIBBOARDGAME_CHECK_EQUAL(points1.size(), points2.size());
+        LIBBOARDGAME_CHECK(equal(points1.begin(), points1.end(),
+                                 points2.begin()));
+        auto& mask1 = bc1.get_move_mask(mv);
+        auto& mask2 = bc2.get_move_mask(mv);
+        LIBBOARDGAME_CHECK_EQUAL(mask1.first_word, mask2.first_word);
+        LIBBOARDGAME_CHECK(memcmp(mask1.bits, mask2.bits,
+                                  sizeof(mask1.bits)) == 0);
+        auto& info1 = bc1.get_move_info_ext_2(mv);
+        auto& info2 = bc2.get_move_info_ext_2(mv);
+        LIBBOARDGAME_CHECK_EQUAL(info1.breaks_symmetry,
+                                 info2.breaks_symmetry);
+        LIBBOARDGAME_CHECK(info1.symmetric_move == info2.symmetric_move);
+    }
+    for (Piece::IntType i = 0; i < bc1.get_nu_pieces(); ++i)
+    {
+        Piece piece(i);
+        LIBBOARDGAME_CHECK_EQUAL(bc1.get_nu_attach_points(piece),
+                                 bc2.get_nu_attach_points(piece));
+        for (Point p : bc1.get_geometry())
+        {
+            auto moves1 = bc1.get_moves(piece, p);
+            auto moves2 = bc2.get_moves(piece, p);
+            LIBBOARDGAME_CHECK_EQUAL(moves1.size(), moves2.size());
+            LIBBOARDGAME_CHECK(equal(moves1.begin(), moves1.end(),
+                                     moves2.begin()));
+        }
+    }
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+/** Test that the move tables are written to the cache and that the tables
+    mapped from the cache are equal to the tables created in memory.
+    Also tests that truncated cache files and files with a wrong header are
+    ignored and replaced. */
+LIBBOARDGAME_TEST_CASE(pentobi_base_board_const_cache)
+{
+#if defined __unix__ || defined __APPLE__
+    auto dir = filesystem::temp_directory_path()
+            / "pentobi_board_const_cache_test";
+    filesystem::remove_all(dir);
+    filesystem::create_directory(dir);
+    BoardConst::set_cache_dir("");
+    BoardConst bc(BoardType::duo, PieceSet::classic);
+    LIBBOARDGAME_CHECK(! bc.is_mapped());
+    BoardConst::set_cache_dir(dir.string());
+    {
+        BoardConst bc_created(BoardType::duo, PieceSet::classic);
+        check_equal_tables(bc, bc_created);
+    }
+    filesystem::path path;
+    for (auto& entry : filesystem::directory_iterator(dir))
+    {
+        LIBBOARDGAME_CHECK(path.empty());
+        path = entry.path();
+    }
+    LIBBOARDGAME_CHECK(! path.empty());
+    auto size = filesystem::file_size(path);
+    {
+        BoardConst bc_loaded(BoardType::duo, PieceSet::classic);
+        LIBBOARDGAME_CHECK(bc_loaded.is_mapped());
+        check_equal_tables(bc, bc_loaded);
+    }
+    // Truncated file
+    filesystem::resize_file(path, size / 2);
+    {
+        BoardConst bc_truncated(BoardType::duo, PieceSet::classic);
+        check_equal_tables(bc, bc_truncated);
+    }
+    LIBBOARDGAME_CHECK_EQUAL(filesystem::file_size(path), size);
+    // Wrong magic (offset 0) and wrong version (offset 8)
+    for (streamoff pos : {0, 8})
+    {
+        char c;
+        {
+            fstream file(path, ios::binary | ios::in | ios::out);
+            file.seekg(pos);
+            file.get(c);
+            file.seekp(pos);
+            file.put(static_cast<char>(c + 1));
+        }
+        {
+            BoardConst bc_wrong_header(BoardType::duo, PieceSet::classic);
+            check_equal_tables(bc, bc_wrong_header);
+        }
+        ifstream file(path, ios::binary);
+        file.seekg(pos);
+        char c_rewritten;
+        file.get(c_rewritten);
+        LIBBOARDGAME_CHECK_EQUAL(c_rewritten, c);
+    }
+    {
+        BoardConst bc_loaded(BoardType::duo, PieceSet::classic);
+        LIBBOARDGAME_CHECK(bc_loaded.is_mapped());
+    }
+    BoardConst::set_cache_dir("");
+    filesystem::remove_all(dir);
+#endif
+}
+
 /** Test that from_string() handles null moves.
     Used for example in pentobi/AnalyzeGameMode.cpp */
 LIBBOARDGAME_TEST_CASE(pentobi_base_board_const_from_string_null)
@@ -47,4 +166,37 @@ LIBBOARDGAME_TEST_CASE(pentobi_base_board_const_symmetry_info)
     LIBBOARDGAME_CHECK_EQUAL(info_ext_2.symmetric_move.to_int(), mv.to_int());
 }
 
+/** Check that the move masks contain exactly the points of the moves in all
+    board types. */
+LIBBOARDGAME_TEST_CASE(pentobi_base_board_const_move_mask)
+{
+    for (auto variant : {Variant::classic, Variant::duo, Variant::junior,
+                         Variant::trigon, Variant::trigon_3, Variant::nexos,
+                         Variant::callisto, Variant::callisto_2,
+                         Variant::callisto_3, Variant::gembloq,
+                         Variant::gembloq_2, Variant::gembloq_3})
+    {
+        auto& bc = BoardConst::get(variant);
+        for (Move::IntType i = 1; i < bc.get_range(); ++i)
+        {
+            Move mv(i);
+            auto& mask = bc.get_move_mask(mv);
+            unsigned nu_bits = 0;
+            for (auto bits : mask.bits)
+                for ( ; bits != 0; bits &= bits - 1)
+                    ++nu_bits;
+            auto points = bc.get_move_points(mv);
+            LIBBOARDGAME_CHECK_EQUAL(nu_bits, points.size());
+            for (auto p : points)
+            {
+                auto j = p.to_int() - mask.first_word * PointBitSet::word_bits;
+                LIBBOARDGAME_CHECK(j < MoveMask::max_words
+                                   * PointBitSet::word_bits);
+                LIBBOARDGAME_CHECK((mask.bits[j / PointBitSet::word_bits]
+                                    >> (j % PointBitSet::word_bits)) & 1);
+            }
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
@@ -24,6 +24,42 @@ void play(Board& bd, Color c, const char* s)
     bd.play(c, mv);
 }
 
+/** Check that the forbidden bit sets are consistent with the forbidden
+    grids. */
+void check_forbidden_set(const Board& bd)
+{
+    for (Color c : bd.get_colors())
+    {
+        for (Point p : bd)
+            LIBBOARDGAME_CHECK_EQUAL(bd.get_forbidden_set(c)[p],
+                                     bd.is_forbidden(p, c));
+        for (Move::IntType i = 1; i < bd.get_board_const().get_range(); ++i)
+        {
+            Move mv(i);
+            bool is_forbidden = false;
+            for (Point p : bd.get_move_points(mv))
+                is_forbidden |= bd.is_forbidden(p, c);
+            LIBBOARDGAME_CHECK_EQUAL(bd.is_forbidden(c, mv), is_forbidden);
+        }
+    }
+}
+
+/** Play moves that are in the middle of the list of legal moves. */
+void play_moves(Board& bd, unsigned nu_moves)
+{
+    auto moves = make_unique<MoveList>();
+    auto marker = make_unique<MoveMarker>();
+    for (unsigned i = 0; i < nu_moves; ++i)
+    {
+        auto c = bd.get_to_play();
+        bd.gen_moves(c, *marker, *moves);
+        marker->clear(*moves);
+        if (moves->empty())
+            break;
+        bd.play(c, (*moves)[moves->size() / 2]);
+    }
+}
+
 } // namespace
 
 //-----------------------------------------------------------------------------
@@ -135,6 +171,111 @@ LIBBOARDGAME_TEST_CASE(pentobi_base_board_gen_moves_classic_initial)
     LIBBOARDGAME_CHECK_EQUAL(moves->size(), 58u);
 }
 
+/** Test that get_hash() does not depend on the move order and is restored
+    by restore_snapshot(). */
+LIBBOARDGAME_TEST_CASE(pentobi_base_board_get_hash)
+{
+    auto bd1 = make_unique<Board>(Variant::duo);
+    auto bd2 = make_unique<Board>(Variant::duo);
+    auto hash_empty = bd1->get_hash();
+    LIBBOARDGAME_CHECK_EQUAL(hash_empty, bd2->get_hash());
+    bd1->take_snapshot();
+    play(*bd1, Color(0), "e9,f9,f10");
+    play(*bd1, Color(1), "j5,j6,j7");
+    play(*bd1, Color(0), "g8,h8");
+    play(*bd1, Color(1), "h4,i4");
+    play(*bd2, Color(0), "g8,h8");
+    play(*bd2, Color(1), "h4,i4");
+    LIBBOARDGAME_CHECK(bd1->get_hash() != bd2->get_hash());
+    play(*bd2, Color(0), "e9,f9,f10");
+    play(*bd2, Color(1), "j5,j6,j7");
+    LIBBOARDGAME_CHECK_EQUAL(bd1->get_hash(), bd2->get_hash());
+    bd2->set_to_play(Color(1));
+    LIBBOARDGAME_CHECK(bd1->get_hash() != bd2->get_hash());
+    bd1->restore_snapshot();
+    LIBBOARDGAME_CHECK_EQUAL(bd1->get_hash(), hash_empty);
+}
+
+/** Test that the forbidden bit sets are updated by play() and
+    restore_snapshot(). */
+LIBBOARDGAME_TEST_CASE(pentobi_base_board_forbidden_set)
+{
+    for (auto variant : {Variant::duo, Variant::trigon_2, Variant::nexos_2,
+                         Variant::gembloq_2})
+    {
+        auto bd = make_unique<Board>(variant);
+        auto moves = make_unique<MoveList>();
+        auto marker = make_unique<MoveMarker>();
+        bd->take_snapshot();
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            auto c = bd->get_to_play();
+            bd->gen_moves(c, *marker, *moves);
+            marker->clear(*moves);
+            if (moves->empty())
+                break;
+            bd->play(c, (*moves)[moves->size() / 2]);
+        }
+        check_forbidden_set(*bd);
+        bd->restore_snapshot();
+        check_forbidden_set(*bd);
+    }
+}
+
+/** Test that restore_snapshot_delta() restores the same state as
+    restore_snapshot(). */
+LIBBOARDGAME_TEST_CASE(pentobi_base_board_restore_snapshot_delta)
+{
+    for (auto variant : {Variant::duo, Variant::trigon_2, Variant::nexos_2,
+                         Variant::callisto_2, Variant::gembloq_2})
+    {
+        auto bd = make_unique<Board>(variant);
+        auto bd_snapshot = make_unique<Board>(variant);
+        play_moves(*bd, 4);
+        bd->take_snapshot();
+        bd_snapshot->copy_from(*bd);
+        play_moves(*bd, 6);
+        switch (bd->get_board_const().get_max_piece_size())
+        {
+        case 5:
+            bd->restore_snapshot_delta<5, 16>();
+            break;
+        case 6:
+            bd->restore_snapshot_delta<6, 22>();
+            break;
+        case 7:
+            bd->restore_snapshot_delta<7, 12>();
+            break;
+        default:
+            bd->restore_snapshot_delta<22, 44>();
+        }
+        LIBBOARDGAME_CHECK_EQUAL(bd->get_nu_moves(),
+                                 bd_snapshot->get_nu_moves());
+        LIBBOARDGAME_CHECK_EQUAL(bd->get_hash(), bd_snapshot->get_hash());
+        LIBBOARDGAME_CHECK(bd->get_to_play() == bd_snapshot->get_to_play());
+        for (Point p : *bd)
+            LIBBOARDGAME_CHECK(bd->get_point_state(p)
+                               == bd_snapshot->get_point_state(p));
+        for (Color c : bd->get_colors())
+        {
+            for (Point p : *bd)
+            {
+                LIBBOARDGAME_CHECK_EQUAL(bd->is_forbidden(p, c),
+                                         bd_snapshot->is_forbidden(p, c));
+                LIBBOARDGAME_CHECK_EQUAL(bd->is_attach_point(p, c),
+                                         bd_snapshot->is_attach_point(p, c));
+            }
+            LIBBOARDGAME_CHECK_EQUAL(bd->get_attach_points(c).size(),
+                                     bd_snapshot->get_attach_points(c).size());
+            LIBBOARDGAME_CHECK_EQUAL(bd->get_points(c),
+                                     bd_snapshot->get_points(c));
+            LIBBOARDGAME_CHECK_EQUAL(bd->get_pieces_left(c).size(),
+                                     bd_snapshot->get_pieces_left(c).size());
+        }
+        check_forbidden_set(*bd);
+    }
+}
+
 /** Test get_place() in a 4-color, 2-player game when the player 1 has
     a higher score but color 1 has less points than color 2. */
 LIBBOARDGAME_TEST_CASE(pentobi_base_board_get_place)
@@ -186,6 +186,7 @@ void GtpEngine::cmd_param_base(Arguments args, Response& response)
     if (args.get_size() == 0)
         response
             << "accept_illegal " << m_accept_illegal << '\n'
+            << "ponder " << m_ponder << '\n'
             << "resign " << m_resign << '\n';
     else
     {
@@ -193,6 +194,8 @@ void GtpEngine::cmd_param_base(Arguments args, Response& response)
         auto name = args.get(0);
         if (name == "accept_illegal")
             m_accept_illegal = args.get<bool>(1);
+        else if (name == "ponder")
+            m_ponder = args.get<bool>(1);
         else if (name == "resign")
             m_resign = args.get<bool>(1);
         else
@@ -207,6 +210,15 @@ void GtpEngine::cmd_param_base(Arguments args, Response& response)
 void GtpEngine::cmd_play(Arguments args)
 {
     play(get_color_arg(args, 0), args, 1);
+    if (m_player == nullptr)
+        return;
+    if (m_ponder)
+        start_ponder();
+    else
+    {
+        auto& bd = get_board();
+        m_player->prepare_followup(bd, bd.get_effective_to_play());
+    }
 }
 
 void GtpEngine::cmd_point_integers(Response& response)
@@ -298,6 +310,8 @@ void GtpEngine::genmove(Color c, Response& response)
     m_game.play(c, mv, true);
     response << bd.to_string(mv, false);
     board_changed();
+    if (m_ponder)
+        start_ponder();
 }
 
 Color GtpEngine::get_color_arg(Arguments args) const
@@ -342,9 +356,20 @@ PlayerBase& GtpEngine::get_player() const
 
 void GtpEngine::on_handle_cmd_begin()
 {
+    // Stop pondering before any command, even if the command does not use
+    // the player, because the command may modify the game or the player.
+    if (m_player != nullptr)
+        m_player->stop_ponder();
     libboardgame_base::flush_log();
 }
 
+void GtpEngine::start_ponder()
+{
+    auto& bd = get_board();
+    if (! bd.is_game_over())
+        m_player->start_ponder(bd, bd.get_effective_to_play());
+}
+
 void GtpEngine::play(Color c, Arguments args, unsigned arg_move_begin)
 {
     auto& bd = get_board();
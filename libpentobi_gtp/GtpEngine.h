@@ -56,6 +56,11 @@ public:
 
     void set_accept_illegal(bool enable) { m_accept_illegal = enable; }
 
+    /** Enable or disable pondering.
+        If enabled, the player continues to think in the background after
+        a genmove or play command until the next command arrives. */
+    void set_ponder(bool enable) { m_ponder = enable; }
+
     /** Enable or disable resigning. */
     void set_resign(bool enable) { m_resign = enable; }
 
@@ -73,6 +78,8 @@ protected:
 private:
     bool m_accept_illegal = false;
 
+    bool m_ponder = false;
+
     bool m_show_board = false;
 
     bool m_resign = true;
@@ -87,6 +94,8 @@ private:
 
     PlayerBase& get_player() const;
 
+    void start_ponder();
+
     void play(Color c, Arguments args, unsigned arg_move_begin);
 };
 
@@ -10,11 +10,13 @@
 #include <iomanip>
 #include "libboardgame_base/CpuTimeSource.h"
 #include "libboardgame_base/Memory.h"
+#include "libboardgame_base/Timer.h"
 #include "libboardgame_base/WallTimeSource.h"
 
 namespace libpentobi_mcts {
 
 using libboardgame_base::CpuTimeSource;
+using libboardgame_base::Timer;
 using libboardgame_base::WallTimeSource;
 using libpentobi_base::BoardType;
 
@@ -61,57 +63,26 @@ const float counts_nexos[Player::max_supported_level] =
 const float counts_callisto_2[Player::max_supported_level] =
     { 30, 87, 300, 1017, 4729, 20435, 122778, 613905, 3069529 };
 
-/** Suggest how much memory to use for the trees depending on the maximum
-    level used. */
-size_t get_memory(unsigned max_level)
-{
-    auto available = libboardgame_base::get_memory();
-    if (available == 0)
-    {
-        LIBBOARDGAME_LOG("WARNING: could not determine system memory"
-                         " (assuming 512MB)");
-        available = 512000000;
-    }
-    // Don't use all of the available memory
-    size_t reasonable = available / 4;
-    size_t wanted = 2000000000;
-    if (max_level < Player::max_supported_level)
-    {
-        // We don't need so much memory if m_max_level is smaller than
-        // max_supported_level. Trigon has the highest relative number of
-        // simulations on lower levels compared to the highest level. The
-        // memory used in a search is not proportional to the number of
-        // simulations (e.g. because the expand threshold increases with the
-        // depth). We approximate this by adding an exponent to the ratio
-        // and not taking into account if m_max_level is very small.
-        static_assert(Player::max_supported_level >= 5);
-        auto factor = pow(counts_trigon[Player::max_supported_level - 1]
-                          / counts_trigon[max(max_level, 5u) - 1], 0.8);
-        wanted = static_cast<size_t>(double(wanted) / factor);
-    }
-    size_t memory = min(wanted, reasonable);
-    LIBBOARDGAME_LOG("Using ", memory / 1000000, " MB of ",
-                     available / 1000000, " MB");
-    return memory;
-}
-
 } // namespace
 
 //-----------------------------------------------------------------------------
 
 Player::Player(Variant initial_variant, unsigned max_level,
-               const string&  books_dir, unsigned nu_threads)
+               const string&  books_dir, unsigned nu_threads, size_t memory)
     : m_is_book_loaded(false),
       m_use_book(true),
       m_resign(false),
+      m_is_book_move(false),
       m_books_dir(books_dir),
       m_max_level(max_level),
       m_level(4),
       m_fixed_simulations(0),
-      m_search(initial_variant, nu_threads, get_memory(max_level)),
+      m_search(initial_variant, nu_threads,
+               memory == 0 ? get_default_memory(max_level) : memory),
       m_book(initial_variant),
       m_time_source(new WallTimeSource)
 {
+    m_early_stop_confidence.fill(0);
     for (unsigned i = 0; i < Board::max_player_moves; ++i)
     {
         // Hand-tuned such that time per move is more evenly spread among all
@@ -153,9 +124,15 @@ Player::Player(Variant initial_variant, unsigned max_level,
     }
 }
 
-Move Player::genmove(const Board& bd, Color c)
+Player::~Player()
+{
+    stop_ponder();
+}
+
+Move Player::find_move(const Board& bd, Color c)
 {
     m_resign = false;
+    m_is_book_move = false;
     if (! bd.has_moves(c))
         return Move::null();
     Move mv;
@@ -173,15 +150,22 @@ Move Player::genmove(const Board& bd, Color c)
         {
             mv = m_book.genmove(bd, c);
             if (! mv.is_null())
+            {
+                m_is_book_move = true;
                 return mv;
+            }
         }
     }
     Float max_count = 0;
     double max_time = 0;
+    double max_time_extended = 0;
     if (m_fixed_simulations > 0)
         max_count = m_fixed_simulations;
     else if (m_fixed_time > 0)
         max_time = m_fixed_time;
+    else if (m_time_manager.is_enabled())
+        m_time_manager.get_time(c, get_expected_moves_left(bd, c), max_time,
+                                max_time_extended);
     else
     {
         switch (board_type)
@@ -245,8 +229,12 @@ Move Player::genmove(const Board& bd, Color c)
     }
     if (max_count != 0)
         LIBBOARDGAME_LOG("MaxCnt ", fixed, setprecision(0), max_count);
+    else if (max_time_extended > max_time)
+        LIBBOARDGAME_LOG("MaxTime ", max_time, " (", max_time_extended, ')');
     else
         LIBBOARDGAME_LOG("MaxTime ", max_time);
+    m_search.set_max_time_extended(max_time_extended);
+    m_search.set_early_stop_confidence(m_early_stop_confidence[level - 1]);
     if (! m_search.search(mv, bd, c, max_count, 0, max_time, *m_time_source))
         return Move::null();
     // Resign only in two-player game variants
@@ -257,6 +245,63 @@ Move Player::genmove(const Board& bd, Color c)
     return mv;
 }
 
+Move Player::genmove(const Board& bd, Color c)
+{
+    Timer timer(*m_time_source);
+    auto mv = find_move(bd, c);
+    if (m_time_manager.is_enabled())
+        m_time_manager.add_used_time(c, timer());
+    return mv;
+}
+
+size_t Player::get_default_memory(unsigned max_level)
+{
+    auto available = libboardgame_base::get_memory();
+    if (available == 0)
+    {
+        LIBBOARDGAME_LOG("WARNING: could not determine system memory"
+                         " (assuming 512MB)");
+        available = 512000000;
+    }
+    // Don't use all of the available memory
+    size_t reasonable = available / 4;
+    size_t wanted = 2000000000;
+    if (max_level < max_supported_level)
+    {
+        // We don't need so much memory if m_max_level is smaller than
+        // max_supported_level. Trigon has the highest relative number of
+        // simulations on lower levels compared to the highest level. The
+        // memory used in a search is not proportional to the number of
+        // simulations (e.g. because the expand threshold increases with the
+        // depth). We approximate this by adding an exponent to the ratio
+        // and not taking into account if m_max_level is very small.
+        static_assert(max_supported_level >= 5);
+        auto factor = pow(counts_trigon[max_supported_level - 1]
+                          / counts_trigon[max(max_level, 5u) - 1], 0.8);
+        wanted = static_cast<size_t>(double(wanted) / factor);
+    }
+    size_t memory = min(wanted, reasonable);
+    LIBBOARDGAME_LOG("Using ", memory / 1000000, " MB of ",
+                     available / 1000000, " MB");
+    return memory;
+}
+
+/** Estimate the number of remaining moves of a color.
+    Colors can usually not place all of their pieces. In self-play games,
+    a color places about 80% of its pieces (between 16 moves in Duo and 20
+    in Nexos), so we assume that a fifth of the pieces will be left at the
+    end of the game. */
+unsigned Player::get_expected_moves_left(const Board& bd, Color c)
+{
+    unsigned nu_pieces = 0;
+    for (Piece::IntType i = 0; i < bd.get_nu_uniq_pieces(); ++i)
+        nu_pieces += bd.get_nu_piece_instances(Piece(i));
+    unsigned nu_left = 0;
+    for (auto piece : bd.get_pieces_left(c))
+        nu_left += bd.get_nu_left_piece(c, piece);
+    return max(nu_left - min(nu_left, nu_pieces / 5), 1u);
+}
+
 Rating Player::get_rating(Variant variant, unsigned level)
 {
     // The ratings are roughly based on Elo differences measured in self-play
@@ -348,11 +393,49 @@ bool Player::load_book(const string& filepath)
     return true;
 }
 
+void Player::prepare_followup(const Board& bd, Color c)
+{
+    m_search.prepare_followup(bd, c);
+}
+
 bool Player::resign() const
 {
     return m_resign;
 }
 
+void Player::set_seed(RandomGenerator::ResultType seed)
+{
+    m_book.set_seed(seed);
+    for (unsigned i = 0; i < m_search.get_nu_threads(); ++i)
+        m_search.get_state(i).set_seed(seed + i);
+}
+
+void Player::start_ponder(const Board& bd, Color c)
+{
+    stop_ponder();
+    if (! bd.has_moves(c))
+        return;
+    if (! m_ponder_bd || m_ponder_bd->get_variant() != bd.get_variant())
+        m_ponder_bd = make_unique<Board>(bd.get_variant());
+    m_ponder_bd->copy_from(bd);
+    m_ponder_thread = thread([this, c] {
+        LIBBOARDGAME_LOG("Pondering");
+        WallTimeSource time_source;
+        Move mv;
+        m_search.search(mv, *m_ponder_bd, c, 0, 0,
+                        numeric_limits<double>::max(), time_source);
+    });
+}
+
+void Player::stop_ponder()
+{
+    if (! m_ponder_thread.joinable())
+        return;
+    m_search.request_stop();
+    m_ponder_thread.join();
+    m_search.clear_stop_request();
+}
+
 void Player::use_cpu_time(bool enable)
 {
     if (enable)
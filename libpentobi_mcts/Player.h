@@ -7,13 +7,16 @@
 #ifndef LIBPENTOBI_MCTS_PLAYER_H
 #define LIBPENTOBI_MCTS_PLAYER_H
 
+#include <thread>
 #include "Search.h"
+#include "TimeManager.h"
 #include "libboardgame_base/Rating.h"
 #include "libpentobi_base/Book.h"
 #include "libpentobi_base/PlayerBase.h"
 
 namespace libpentobi_mcts {
 
+using libboardgame_base::RandomGenerator;
 using libboardgame_base::Rating;
 using libpentobi_base::Book;
 using libpentobi_base::PlayerBase;
@@ -34,14 +37,24 @@ public:
         @param max_level The maximum level used
         @param books_dir Directory containing opening books.
         @param nu_threads The number of threads to use in the search (0 means
-        to select a reasonable default value) */
+        to select a reasonable default value)
+        @param memory The memory for the search tree (0 means to select a
+        reasonable default value, see get_default_memory()) */
     Player(Variant initial_variant, unsigned max_level, const string& books_dir,
-           unsigned nu_threads = 0);
+           unsigned nu_threads = 0, size_t memory = 0);
+
+    ~Player() override;
 
     Move genmove(const Board& bd, Color c) override;
 
+    void prepare_followup(const Board& bd, Color c) override;
+
     bool resign() const override;
 
+    void start_ponder(const Board& bd, Color c) override;
+
+    void stop_ponder() override;
+
     Float get_fixed_simulations() const;
 
     double get_fixed_time() const;
@@ -57,10 +70,30 @@ public:
         (maximum) time per search independent of the playing level. */
     void set_fixed_time(double seconds);
 
+    /** Get the confidence factor for stopping the search early in a level.
+        @see set_early_stop_confidence() */
+    Float get_early_stop_confidence(unsigned level) const;
+
+    /** Set the confidence factor for stopping the search early in a level.
+        The default is 0 (disabled) for all levels, because the number of
+        simulations of the levels was calibrated without early stopping.
+        @see Search::set_early_stop_confidence() */
+    void set_early_stop_confidence(unsigned level, Float factor);
+
+    /** Get the game clock.
+        If time settings are set in the time manager, the time per move is
+        determined from the remaining time of the color to play, unless
+        fixed simulations or a fixed time are used. genmove() updates the
+        clock with the time used for the move. */
+    TimeManager& get_time_manager();
+
     bool get_use_book() const;
 
     void set_use_book(bool enable);
 
+    /** Was the move of the last genmove() taken from the opening book? */
+    bool is_book_move() const { return m_is_book_move; }
+
     unsigned get_level() const;
 
     void set_level(unsigned level);
@@ -86,6 +119,18 @@ public:
     /** Get an estimated Elo-rating of the current level. */
     Rating get_rating(Variant variant) const;
 
+    /** Suggest how much memory to use for the trees depending on the maximum
+        level used. */
+    static size_t get_default_memory(unsigned max_level);
+
+    /** Reseed the random generators of the book and the search.
+        Players created with the same global seed (see
+        RandomGenerator::set_global_seed()) generate the same moves. This
+        function can be used to make them differ, e.g. in concurrent
+        self-play games. It needs to be called again if the threads of the
+        search are re-created (see Search::set_pin_threads()). */
+    void set_seed(RandomGenerator::ResultType seed);
+
 private:
     bool m_is_book_loaded;
 
@@ -93,6 +138,8 @@ private:
 
     bool m_resign;
 
+    bool m_is_book_move;
+
     string m_books_dir;
 
     unsigned m_max_level;
@@ -111,20 +158,39 @@ private:
 
     Float m_fixed_simulations;
 
+    array<Float, max_supported_level> m_early_stop_confidence;
+
     double m_fixed_time;
 
     Search m_search;
 
+    TimeManager m_time_manager;
+
     Book m_book;
 
     unique_ptr<TimeSource> m_time_source;
 
+    /** Copy of the board used while pondering. */
+    unique_ptr<Board> m_ponder_bd;
+
+    thread m_ponder_thread;
+
+
+    Move find_move(const Board& bd, Color c);
+
+    static unsigned get_expected_moves_left(const Board& bd, Color c);
 
     void init_settings();
 
     bool load_book(const string& filepath);
 };
 
+inline Float Player::get_early_stop_confidence(unsigned level) const
+{
+    LIBBOARDGAME_ASSERT(level >= 1 && level <= max_supported_level);
+    return m_early_stop_confidence[level - 1];
+}
+
 inline Float Player::get_fixed_simulations() const
 {
     return m_fixed_simulations;
@@ -145,6 +211,11 @@ inline Rating Player::get_rating(Variant variant) const
     return get_rating(variant, m_level);
 }
 
+inline TimeManager& Player::get_time_manager()
+{
+    return m_time_manager;
+}
+
 inline Search& Player::get_search()
 {
     return m_search;
@@ -155,6 +226,12 @@ inline bool Player::get_use_book() const
     return m_use_book;
 }
 
+inline void Player::set_early_stop_confidence(unsigned level, Float factor)
+{
+    LIBBOARDGAME_ASSERT(level >= 1 && level <= max_supported_level);
+    m_early_stop_confidence[level - 1] = factor;
+}
+
 inline void Player::set_fixed_simulations(Float n)
 {
     m_fixed_simulations = n;
@@ -10,6 +10,12 @@
 #include "libpentobi_base/Board.h"
 #include "libpentobi_base/PointList.h"
 
+#if defined(__GNUC__) && defined(__x86_64__) \
+    && ! defined(LIBBOARDGAME_MCTS_NO_SIMD)
+#define LIBPENTOBI_MCTS_SIMD_FEATURES
+#include <immintrin.h>
+#endif
+
 namespace libpentobi_mcts {
 
 using libpentobi_base::Board;
@@ -64,6 +70,11 @@ public:
             : m_value(playout_features.m_point_value[p])
         { }
 
+        /** Constructor from an already computed sum of feature values. */
+        explicit Compute(IntType value)
+            : m_value(value)
+        { }
+
         /** Add a point of the move. */
         void add(Point p, const PlayoutFeatures& playout_features)
         {
@@ -96,6 +107,13 @@ public:
 
     void restore_snapshot(const Board& bd);
 
+    /** Restore the snapshot by rolling back only the points changed by the
+        moves played since the snapshot and the local points.
+        Must be called before the snapshot of the board is restored.
+        @see Board::restore_snapshot_delta() */
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+    void restore_snapshot_delta(const Board& bd);
+
     /** Set points of move to forbidden. */
     template<unsigned MAX_SIZE>
     void set_forbidden(const MoveInfo<MAX_SIZE>& info);
@@ -107,6 +125,22 @@ public:
     template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
     void set_local(const Board& bd);
 
+    /** Check if compute_avx2() can be used.
+        The CPU features are detected at runtime on the first call. */
+    static bool is_avx2_supported();
+
+#ifdef LIBPENTOBI_MCTS_SIMD_FEATURES
+    /** Compute the sum of the feature values for all points of a move with
+        AVX2 gather instructions.
+        The result is the same as adding all points with Compute. Gathering
+        the values of 8 points at once is only faster than adding them point
+        by point if the pieces are large (GembloQ).
+        @pre MAX_SIZE >= 8 */
+    template<unsigned MAX_SIZE>
+    __attribute__((target("avx2")))
+    Compute compute_avx2(const MoveInfo<MAX_SIZE>& info) const;
+#endif
+
 private:
     GridExt<IntType> m_point_value;
 
@@ -132,6 +166,47 @@ inline void PlayoutFeatures::add_local(const Board& bd, Point p, Color to_play,
     }
 }
 
+#ifdef LIBPENTOBI_MCTS_SIMD_FEATURES
+template<unsigned MAX_SIZE>
+__attribute__((target("avx2")))
+inline auto PlayoutFeatures::compute_avx2(const MoveInfo<MAX_SIZE>& info) const
+-> Compute
+{
+    static_assert(MAX_SIZE >= 8);
+    static_assert(sizeof(Point) == 2);
+    static_assert(sizeof(IntType) == 4);
+    auto values = reinterpret_cast<const int*>(&m_point_value[Point(0)]);
+    auto points = reinterpret_cast<const __m128i*>(info.begin());
+    auto sum = _mm256_setzero_si256();
+    unsigned i = 0;
+    for ( ; i + 8 <= MAX_SIZE; i += 8)
+    {
+        auto idx = _mm256_cvtepu16_epi32(_mm_loadu_si128(points));
+        sum = _mm256_add_epi32(sum, _mm256_i32gather_epi32(values, idx, 4));
+        points = reinterpret_cast<const __m128i*>(info.begin() + i + 8);
+    }
+    if (MAX_SIZE % 8 != 0)
+    {
+        // Read the last 8 points of the point array, which avoids reading
+        // beyond the end of the move info, and ignore the points that were
+        // already added
+        auto idx = _mm256_cvtepu16_epi32(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(info.begin() + MAX_SIZE - 8)));
+        auto lane = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        auto is_new = _mm256_cmpgt_epi32(
+                    lane, _mm256_set1_epi32(7 - static_cast<int>(MAX_SIZE % 8)));
+        sum = _mm256_add_epi32(
+                    sum, _mm256_and_si256(
+                        is_new, _mm256_i32gather_epi32(values, idx, 4)));
+    }
+    auto sum_4 = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                               _mm256_extracti128_si256(sum, 1));
+    sum_4 = _mm_add_epi32(sum_4, _mm_shuffle_epi32(sum_4, 0x4e));
+    sum_4 = _mm_add_epi32(sum_4, _mm_shuffle_epi32(sum_4, 0xb1));
+    return Compute(static_cast<IntType>(_mm_cvtsi128_si32(sum_4)));
+}
+#endif // LIBPENTOBI_MCTS_SIMD_FEATURES
+
 inline void PlayoutFeatures::init_snapshot(const Board& bd, Color c)
 {
     m_point_value[Point::null()] = 0;
@@ -141,11 +216,49 @@ inline void PlayoutFeatures::init_snapshot(const Board& bd, Color c)
 }
 
 
+inline bool PlayoutFeatures::is_avx2_supported()
+{
+#ifdef LIBPENTOBI_MCTS_SIMD_FEATURES
+    static const bool is_supported = __builtin_cpu_supports("avx2");
+    return is_supported;
+#else
+    return false;
+#endif
+}
+
 inline void PlayoutFeatures::restore_snapshot(const Board& bd)
 {
     m_point_value.copy_from(m_snapshot, bd.get_geometry());
 }
 
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+inline void PlayoutFeatures::restore_snapshot_delta(const Board& bd)
+{
+    auto& bc = bd.get_board_const();
+    auto move_info_array = bc.get_move_info_array();
+    auto move_info_ext_array = bc.get_move_info_ext_array();
+    auto& moves = bd.get_moves();
+    for (auto i = moves.end() - bd.get_nu_moves_since_snapshot();
+         i != moves.end(); ++i)
+    {
+        auto& info = BoardConst::get_move_info<MAX_SIZE>(i->move,
+                                                         move_info_array);
+        auto p = info.begin();
+        auto end = info.end();
+        do
+            m_point_value[*p] = m_snapshot[*p];
+        while (++p != end);
+        auto& info_ext = BoardConst::get_move_info_ext<MAX_ADJ_ATTACH>(
+                    i->move, move_info_ext_array);
+        end = info_ext.end_adj();
+        for (p = info_ext.begin_adj(); p != end; ++p)
+            m_point_value[*p] = m_snapshot[*p];
+    }
+    for (Point p : m_local_points)
+        m_point_value[p] = m_snapshot[p];
+    m_local_points.clear();
+}
+
 template<unsigned MAX_SIZE>
 inline void PlayoutFeatures::set_forbidden(const MoveInfo<MAX_SIZE>& info)
 {
@@ -43,7 +43,8 @@ class PriorKnowledge
 {
 public:
     using Node =
-        libboardgame_mcts::Node<Move, Float, SearchParamConst::multithread>;
+        libboardgame_mcts::Node<Move, Float, SearchParamConst::multithread,
+                                SearchParamConst::pack_node_values>;
 
     using Tree = libboardgame_mcts::Tree<Node>;
 
@@ -6,10 +6,15 @@
 
 #include "Search.h"
 
+#include <iomanip>
 #include "Util.h"
+#include "libboardgame_base/WallTimeSource.h"
 
 namespace libpentobi_mcts {
 
+using libboardgame_base::Timer;
+using libboardgame_base::WallTimeSource;
+
 //-----------------------------------------------------------------------------
 
 Search::Search(Variant initial_variant, unsigned nu_threads, size_t memory)
@@ -23,8 +28,20 @@ Search::Search(Variant initial_variant, unsigned nu_threads, size_t memory)
 
 bool Search::check_followup(ArrayList<Move, max_moves>& sequence)
 {
-    auto& bd = get_board();
-    m_history.init(bd, m_to_play);
+    bool is_followup = get_followup(get_board(), m_to_play, sequence);
+    m_last_history = m_history;
+    return is_followup;
+}
+
+unique_ptr<State> Search::create_state()
+{
+    return make_unique<State>(m_variant, m_shared_const);
+}
+
+bool Search::get_followup(const Board& bd, Color to_play,
+                          ArrayList<Move, max_moves>& sequence)
+{
+    m_history.init(bd, to_play);
     bool is_followup = m_history.is_followup(m_last_history, sequence);
 
     // If avoid_symmetric_draw is enabled, class State uses a different
@@ -34,20 +51,14 @@ bool Search::check_followup(ArrayList<Move, max_moves>& sequence)
     // symmetric draws to avoid going for such a draw). In this case, we cannot
     // reuse parts of the old search tree if the computer plays both colors.
     if (m_shared_const.avoid_symmetric_draw
-            && is_followup && m_to_play != m_last_history.get_to_play()
+            && is_followup && to_play != m_last_history.get_to_play()
             && has_central_symmetry(bd.get_variant())
             && ! check_symmetry_broken(bd))
         is_followup = false;
 
-    m_last_history = m_history;
     return is_followup;
 }
 
-unique_ptr<State> Search::create_state()
-{
-    return make_unique<State>(m_variant, m_shared_const);
-}
-
 void Search::get_root_position(Variant& variant, Setup& setup) const
 {
     m_last_history.get_as_setup(variant, setup);
@@ -56,7 +67,19 @@ void Search::get_root_position(Variant& variant, Setup& setup) const
 
 void Search::on_start_search(bool is_followup)
 {
+    WallTimeSource time_source;
+    Timer timer(time_source);
     m_shared_const.init(is_followup);
+    LIBBOARDGAME_LOG(is_followup ? "Updated" : "Initialized",
+                     " precomputed moves (tm=", fixed, setprecision(4),
+                     timer(), ")");
+}
+
+void Search::prepare_followup(const Board& bd, Color to_play)
+{
+    ArrayList<Move, max_moves> sequence;
+    if (get_followup(bd, to_play, sequence))
+        SearchBase::prepare_followup(sequence);
 }
 
 bool Search::search(Move& mv, const Board& bd, Color to_play,
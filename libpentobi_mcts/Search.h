@@ -70,6 +70,11 @@ public:
                 size_t min_simulations, double max_time,
                 TimeSource& time_source);
 
+    /** Prepare the tree for a search in a follow-up position of the last
+        search in the background.
+        @see SearchBase::prepare_followup() */
+    void prepare_followup(const Board& bd, Color to_play);
+
     /** Get color to play at root node of the last search. */
     Color get_to_play() const;
 
@@ -98,6 +103,9 @@ private:
 
     const Board& get_board() const;
 
+    bool get_followup(const Board& bd, Color to_play,
+                      ArrayList<Move, max_moves>& sequence);
+
     void set_default_param(Variant variant);
 };
 
@@ -59,6 +59,24 @@ struct SearchParamConst
     static constexpr size_t lgr_hash_table_size = (1 << 21);
 #endif
 
+#ifdef LIBPENTOBI_MCTS_TRANSPOSITIONS
+    static constexpr bool use_transpositions = true;
+#else
+    static constexpr bool use_transpositions = false;
+#endif
+
+#ifdef PENTOBI_LOW_RESOURCES
+    static constexpr size_t transposition_table_size = (1 << 18);
+#else
+    static constexpr size_t transposition_table_size = (1 << 20);
+#endif
+
+#ifdef LIBPENTOBI_MCTS_PACKED_NODE_VALUES
+    static constexpr bool pack_node_values = true;
+#else
+    static constexpr bool pack_node_values = false;
+#endif
+
     static constexpr bool virtual_loss = true;
 
     static constexpr Float child_min_count = 3;
@@ -74,6 +92,8 @@ struct SearchParamConst
     static constexpr Float expansion_threshold_inc = 0.5f;
 
     static constexpr double expected_sim_per_sec = 100;
+
+    static constexpr double tree_merge_interval = 0.05;
 };
 
 //-----------------------------------------------------------------------------
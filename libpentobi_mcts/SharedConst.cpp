@@ -208,8 +208,6 @@ void SharedConst::init(bool is_followup)
 {
     auto& bd = *board;
     auto& bc = bd.get_board_const();
-
-    // Initialize precomp_moves
     PointList points;
     unsigned n = 0;
     for (Point p : bd)
@@ -218,70 +216,81 @@ void SharedConst::init(bool is_followup)
     points.resize(n);
     for (Color c : bd.get_colors())
     {
-        auto& precomp = precomp_moves[c];
-        auto& old_precomp = (is_followup ? precomp : bc.get_precomp_moves());
-        m_is_forbidden.set();
+        if (is_followup)
+            update_precomp_moves(c, points);
+        else
+            init_precomp_moves(c, points);
+        m_root_forbidden[c] = bd.get_forbidden_set(c);
+    }
+    if (! is_followup)
+        init_pieces_considered();
+    if (bd.get_piece_set() == PieceSet::callisto)
+        init_one_piece_callisto(is_followup);
+}
 
-        // Don't use bd.get_pieces_left() because its ordering is not preserved
-        // during a game. The in-place construction requires that the loop
-        // iterates in the same order as during the last construction such that
-        // it doesn't overwrite elements it still needs to read.
-        Board::PiecesLeftList pieces;
-        for (Piece::IntType i = 0; i < bc.get_nu_pieces(); ++i)
-            if (bd.is_piece_left(c, Piece(i)))
-                pieces.push_back(Piece(i));
+void SharedConst::init_precomp_moves(Color c, const PointList& points)
+{
+    auto& bd = *board;
+    auto& bc = bd.get_board_const();
+    auto& precomp = precomp_moves[c];
+    auto& full_precomp = bc.get_precomp_moves();
+    m_is_forbidden.set();
 
-        for (Point p : points)
-            if (! bd.is_forbidden(p, c))
+    // Don't use bd.get_pieces_left() because its ordering is not preserved
+    // during a game. The lists at a point are stored ordered by piece
+    // (see PrecompMoves).
+    Board::PiecesLeftList pieces;
+    for (Piece::IntType i = 0; i < bc.get_nu_pieces(); ++i)
+        if (bd.is_piece_left(c, Piece(i)))
+            pieces.push_back(Piece(i));
+
+    for (Point p : points)
+        if (! bd.is_forbidden(p, c))
+        {
+            auto adj_status = bd.get_adj_status(p, c);
+            for (Piece piece : pieces)
             {
-                auto adj_status = bd.get_adj_status(p, c);
-                for (Piece piece : pieces)
-                {
-                    if (! old_precomp.has_moves(piece, p, adj_status))
-                        continue;
-                    for (Move mv : old_precomp.get_moves(piece, p, adj_status))
-                        if (m_is_forbidden[mv] && ! bd.is_forbidden(c, mv))
-                            m_is_forbidden.clear(mv);
-                }
+                if (! full_precomp.has_moves(piece, p, adj_status))
+                    continue;
+                for (Move mv : full_precomp.get_moves(piece, p, adj_status))
+                    if (m_is_forbidden[mv] && ! bd.is_forbidden(c, mv))
+                        m_is_forbidden.clear(mv);
             }
-        if (! is_followup)
-            for (Point p : points)
-                if (! bd.is_forbidden(p, c))
-                {
-                    auto adj_status = bd.get_adj_status(p, c);
-                    for (unsigned i = 0; i < PrecompMoves::nu_adj_status; ++i)
-                        if (is_followup_adj_status(i, adj_status))
-                            for (auto piece : pieces)
-                                precomp.set_list_range(p, i, piece, 0, 0);
-                }
-        unsigned n = 0;
-        for (Point p : points)
+        }
+    for (Point p : points)
+        if (! bd.is_forbidden(p, c))
         {
-            if (bd.is_forbidden(p, c))
-                continue;
             auto adj_status = bd.get_adj_status(p, c);
             for (unsigned i = 0; i < PrecompMoves::nu_adj_status; ++i)
+                if (is_followup_adj_status(i, adj_status))
+                    for (auto piece : pieces)
+                        precomp.set_list_range(p, i, piece, 0, 0);
+        }
+    unsigned n = 0;
+    for (Point p : points)
+    {
+        if (bd.is_forbidden(p, c))
+            continue;
+        auto adj_status = bd.get_adj_status(p, c);
+        auto point_begin = n;
+        for (unsigned i = 0; i < PrecompMoves::nu_adj_status; ++i)
+        {
+            if (! is_followup_adj_status(i, adj_status))
+                continue;
+            for (auto piece : pieces)
             {
-                if (! is_followup_adj_status(i, adj_status))
+                if (! full_precomp.has_moves(piece, p, i))
                     continue;
-                for (auto piece : pieces)
-                {
-                    if (! old_precomp.has_moves(piece, p, i))
-                        continue;
-                    auto begin = n;
-                    for (auto& mv : old_precomp.get_moves(piece, p, i))
-                        if (! m_is_forbidden[mv])
-                            precomp.set_move(n++, mv);
-                    precomp.set_list_range(p, i, piece, begin, n - begin);
-                }
+                auto begin = n;
+                for (auto& mv : full_precomp.get_moves(piece, p, i))
+                    if (! m_is_forbidden[mv])
+                        precomp.set_move(n++, mv);
+                precomp.set_list_range(p, i, piece, begin - point_begin,
+                                       n - begin);
             }
         }
+        precomp.set_point_begin(p, point_begin);
     }
-
-    if (! is_followup)
-        init_pieces_considered();
-    if (bd.get_piece_set() == PieceSet::callisto)
-        init_one_piece_callisto(is_followup);
 }
 
 void SharedConst::init_one_piece_callisto(bool is_followup)
@@ -363,6 +372,72 @@ void SharedConst::init_pieces_considered()
     is_piece_considered_none.fill(false);
 }
 
+void SharedConst::update_precomp_moves(Color c, const PointList& points)
+{
+    auto& bd = *board;
+    // All moves in the lists were legal in the root position of the last
+    // initialization and the forbidden points can only increase in a
+    // follow-up position, so a move became illegal if and only if it contains
+    // a point that became forbidden since then.
+    m_new_forbidden.set_difference(bd.get_forbidden_set(c),
+                                   m_root_forbidden[c]);
+    if (m_new_forbidden.empty())
+        return;
+    auto& precomp = precomp_moves[c];
+    auto& pieces = bd.get_pieces_left(c);
+
+    // The lists for the current adjacent status of a point contain all moves
+    // of the lists for its follow-up states, so it is sufficient to check
+    // them and only the lists at points with such moves need to be updated.
+    m_is_forbidden.clear();
+    PointList changed_points;
+    for (Point p : points)
+    {
+        if (bd.is_forbidden(p, c))
+            continue;
+        auto adj_status = bd.get_adj_status(p, c);
+        bool is_changed = false;
+        for (Piece piece : pieces)
+        {
+            if (! precomp.has_moves(piece, p, adj_status))
+                continue;
+            for (Move mv : precomp.get_moves(piece, p, adj_status))
+                if (m_new_forbidden.intersects(bd.get_move_mask(mv)))
+                {
+                    m_is_forbidden.set(mv);
+                    is_changed = true;
+                }
+        }
+        if (is_changed)
+            changed_points.push_back(p);
+    }
+
+    // Remove the moves in place, which leaves the beginning of the lists
+    // unchanged
+    for (Point p : changed_points)
+    {
+        auto adj_status = bd.get_adj_status(p, c);
+        for (unsigned i = 0; i < PrecompMoves::nu_adj_status; ++i)
+        {
+            if (! is_followup_adj_status(i, adj_status))
+                continue;
+            for (Piece piece : pieces)
+            {
+                if (! precomp.has_moves(piece, p, i))
+                    continue;
+                auto moves = precomp.get_moves(piece, p, i);
+                auto begin = static_cast<unsigned>(
+                            moves.begin() - precomp.move_lists_begin());
+                auto n = begin;
+                for (Move mv : moves)
+                    if (! m_is_forbidden[mv])
+                        precomp.set_move(n++, mv);
+                precomp.set_list_size(p, i, piece, n - begin);
+            }
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 
 } // namespace libpentobi_mcts
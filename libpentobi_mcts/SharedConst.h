@@ -21,6 +21,7 @@ using libpentobi_base::Move;
 using libpentobi_base::MoveMarker;
 using libpentobi_base::PieceMap;
 using libpentobi_base::Point;
+using libpentobi_base::PointBitSet;
 using libpentobi_base::PointList;
 using libpentobi_base::PrecompMoves;
 
@@ -75,6 +76,11 @@ public:
 
     explicit SharedConst(const Color& to_play);
 
+    /** Initialize for a search in the current position of board.
+        @param is_followup true if the position is a follow-up position of
+        the last initialization. In this case, precomp_moves is updated in
+        place by removing the moves that contain points that became forbidden
+        since then. */
     void init(bool is_followup);
 
 private:
@@ -82,9 +88,21 @@ private:
         Reused for efficiency. */
     MoveMarker m_is_forbidden;
 
+    /** Temporary variable used in init().
+        Reused for efficiency. */
+    PointBitSet m_new_forbidden;
+
+    /** Forbidden points of each color in the root position of the last
+        initialization. */
+    ColorMap<PointBitSet> m_root_forbidden;
+
     void init_one_piece_callisto(bool is_followup);
 
     void init_pieces_considered();
+
+    void init_precomp_moves(Color c, const PointList& points);
+
+    void update_precomp_moves(Color c, const PointList& points);
 };
 
 //-----------------------------------------------------------------------------
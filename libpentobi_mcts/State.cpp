@@ -15,6 +15,7 @@
 namespace libpentobi_mcts {
 
 using libboardgame_base::fast_exp;
+using libboardgame_base::lower_bound_branchless;
 using libpentobi_base::get_multiplayer_result;
 using libpentobi_base::BoardType;
 using libpentobi_base::PointState;
@@ -159,6 +160,13 @@ bool State::check_move(Move mv, const MoveInfo<MAX_SIZE>& info,
     PlayoutFeatures::Compute features(*p, playout_features);
     for (unsigned i = 1; i < MAX_SIZE; ++i)
         features.add(*(++p), playout_features);
+    return check_move(mv, features, gamma_piece, moves, nu_moves, total_gamma);
+}
+
+inline bool State::check_move(Move mv, PlayoutFeatures::Compute features,
+                              float gamma_piece, MoveList& moves,
+                              unsigned& nu_moves, float& total_gamma)
+{
     if (features.is_forbidden())
         return false;
     auto gamma = gamma_piece;
@@ -378,43 +386,17 @@ bool State::gen_children(Tree::NodeExpander& expander, Float root_val)
                 root_val);
 }
 
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
 bool State::gen_playout_move_full(PlayerMove& mv)
 {
     Color to_play = m_bd.get_to_play();
     while (true)
     {
         if (! m_is_move_list_initialized[to_play])
-        {
-            if (m_max_piece_size == 5)
-            {
-                if (m_is_callisto)
-                    init_moves_with_gamma<5, 16, true>(to_play);
-                else
-                    init_moves_with_gamma<5, 16, false>(to_play);
-            }
-            else if (m_max_piece_size == 6)
-                init_moves_with_gamma<6, 22, false>(to_play);
-            else if (m_max_piece_size == 7)
-                init_moves_with_gamma<7, 12, false>(to_play);
-            else
-                init_moves_with_gamma<22, 44, false>(to_play);
-        }
+            init_moves_with_gamma<MAX_SIZE, MAX_ADJ_ATTACH, IS_CALLISTO>(
+                        to_play);
         else if (m_has_moves[to_play])
-        {
-            if (m_max_piece_size == 5)
-            {
-                if (m_is_callisto)
-                    update_moves<5, 16, true>(to_play);
-                else
-                    update_moves<5, 16, false>(to_play);
-            }
-            else if (m_max_piece_size == 6)
-                update_moves<6, 22, false>(to_play);
-            else if (m_max_piece_size == 7)
-                update_moves<7, 12, false>(to_play);
-            else
-                update_moves<22, 44, false>(to_play);
-        }
+            update_moves<MAX_SIZE, MAX_ADJ_ATTACH, IS_CALLISTO>(to_play);
         if ((m_has_moves[to_play] = ! m_moves[to_play].empty()))
             break;
         if (++m_nu_passes == m_nu_colors)
@@ -432,13 +414,13 @@ bool State::gen_playout_move_full(PlayerMove& mv)
 
     auto& moves = m_moves[to_play];
     LIBBOARDGAME_ASSERT(! moves.empty());
-    auto total_gamma = m_cumulative_gamma[moves.size() - 1];
-    auto begin = m_cumulative_gamma.begin();
-    auto end = begin + moves.size();
+    auto nu_moves = moves.size();
+    auto total_gamma = m_cumulative_gamma[nu_moves - 1];
     auto random = m_random.generate_float(0, total_gamma);
-    auto pos = lower_bound(begin, end, random);
-    LIBBOARDGAME_ASSERT(pos != end);
-    mv = {get_player(), moves[static_cast<unsigned>(pos - begin)]};
+    auto pos = lower_bound_branchless(m_cumulative_gamma.data(), nu_moves,
+                                      random);
+    LIBBOARDGAME_ASSERT(pos != nu_moves);
+    mv = {get_player(), moves[pos]};
     return true;
 }
 
@@ -780,6 +762,55 @@ void State::play_expanded_child(Move mv)
     }
 }
 
+void State::playout(const LastGoodReply& lgr, SimulationMoves& moves)
+{
+    if (m_max_piece_size == 5)
+    {
+        if (m_is_callisto)
+            playout<5, 16, true>(lgr, moves);
+        else
+            playout<5, 16, false>(lgr, moves);
+    }
+    else if (m_max_piece_size == 6)
+        playout<6, 22, false>(lgr, moves);
+    else if (m_max_piece_size == 7)
+        playout<7, 12, false>(lgr, moves);
+    else
+        playout<22, 44, false>(lgr, moves);
+}
+
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
+void State::playout(const LastGoodReply& lgr, SimulationMoves& moves)
+{
+    auto nu_moves = moves.size();
+    Move last = nu_moves > 0 ? moves[nu_moves - 1].move : Move::null();
+    Move second_last = nu_moves > 1 ? moves[nu_moves - 2].move : Move::null();
+    PlayerMove mv;
+    while (gen_playout_move<MAX_SIZE, MAX_ADJ_ATTACH, IS_CALLISTO>(
+               lgr, last, second_last, mv))
+    {
+        play_playout<MAX_SIZE, MAX_ADJ_ATTACH>(mv.move);
+        moves.push_back(mv);
+        second_last = last;
+        last = mv.move;
+    }
+}
+
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+void State::restore_snapshot_delta()
+{
+    for (Color c : Color::Range(m_nu_colors))
+    {
+        m_playout_features[c].restore_snapshot_delta<MAX_SIZE, MAX_ADJ_ATTACH>(
+                    m_bd);
+        // m_moves_added_at is only set at attach points and the attach point
+        // lists of the board contain all attach points since the snapshot
+        for (Point p : m_bd.get_attach_points(c))
+            m_moves_added_at[c][p] = false;
+    }
+    m_bd.restore_snapshot_delta<MAX_SIZE, MAX_ADJ_ATTACH>();
+}
+
 void State::start_search()
 {
     auto& bd = *m_shared_const.board;
@@ -788,10 +819,20 @@ void State::start_search()
     m_bd.take_snapshot();
     m_nu_colors = bd.get_nu_colors();
     m_is_callisto = bd.is_callisto();
+    auto& geo = m_bd.get_geometry();
     for (Color c : Color::Range(m_nu_colors))
+    {
+        // restore_snapshot_delta() requires that only the points changed
+        // during a simulation differ from the snapshot
         m_playout_features[c].init_snapshot(m_bd, c);
+        m_playout_features[c].restore_snapshot(m_bd);
+        m_moves_added_at[c].fill(false, geo);
+    }
     m_bc = &m_bd.get_board_const();
     m_max_piece_size = m_bc->get_max_piece_size();
+    // Approximate break-even point between restoring the points changed by
+    // each move and copying the state of all points (measured on x86-64)
+    m_max_moves_restore_delta = geo.get_range() / (20 * m_max_piece_size);
     m_move_info_array = m_bc->get_move_info_array();
     m_move_info_ext_array = m_bc->get_move_info_ext_array();
     m_check_terminate_early =
@@ -829,39 +870,64 @@ void State::start_search()
 
 void State::start_simulation([[maybe_unused]] size_t n)
 {
-    m_bd.restore_snapshot();
+    if (m_bd.get_nu_moves_since_snapshot() <= m_max_moves_restore_delta)
+    {
+        if (m_max_piece_size == 5)
+            restore_snapshot_delta<5, 16>();
+        else if (m_max_piece_size == 6)
+            restore_snapshot_delta<6, 22>();
+        else if (m_max_piece_size == 7)
+            restore_snapshot_delta<7, 12>();
+        else
+            restore_snapshot_delta<22, 44>();
+    }
+    else
+    {
+        m_bd.restore_snapshot();
+        auto& geo = m_bd.get_geometry();
+        for (Color c : Color::Range(m_nu_colors))
+        {
+            m_playout_features[c].restore_snapshot(m_bd);
+            m_moves_added_at[c].fill(false, geo);
+        }
+    }
     m_force_consider_all_pieces = false;
-    auto& geo = m_bd.get_geometry();
     for (Color c : Color::Range(m_nu_colors))
     {
         m_has_moves[c] = true;
         m_is_move_list_initialized[c] = false;
-        m_playout_features[c].restore_snapshot(m_bd);
-        m_moves_added_at[c].fill(false, geo);
     }
     m_nu_passes = 0;
 }
 
-template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
-void State::update_moves(Color c)
+template<unsigned MAX_SIZE>
+void State::update_old_moves(Color c, unsigned& nu_moves, float& total_gamma)
 {
+#ifdef LIBPENTOBI_MCTS_SIMD_FEATURES
+    if constexpr (MAX_SIZE > 8)
+        if (PlayoutFeatures::is_avx2_supported())
+        {
+            update_old_moves_avx2<MAX_SIZE>(c, nu_moves, total_gamma);
+            return;
+        }
+#endif
     auto& playout_features = m_playout_features[c];
-    playout_features.set_local<MAX_SIZE, MAX_ADJ_ATTACH, IS_CALLISTO>(m_bd);
-
     auto& marker = m_marker[c];
-
-    // Find old moves that are still legal
-    auto& is_forbidden = m_bd.is_forbidden(c);
     auto& moves = m_moves[c];
-    unsigned nu_moves = 0;
-    float total_gamma = 0;
+    auto n = moves.size();
+    // The move infos of the moves in the list are at random positions in a
+    // table that does not fit into the CPU cache in game variants with large
+    // boards. Prefetching them a few moves ahead hides most of the memory
+    // latency.
     Piece piece;
     if (m_nu_new_moves[c] == 1 &&
             ! m_bd.is_piece_left(
                 c, (piece =
                     get_move_info<MAX_SIZE>(m_last_move[c]).get_piece())))
-        for (Move mv : moves)
+        for (unsigned i = 0; i < n; ++i)
         {
+            prefetch_move_info<MAX_SIZE>(moves, i + prefetch_distance);
+            auto mv = moves[i];
             auto& info = get_move_info<MAX_SIZE>(mv);
             if (info.get_piece() == piece
                     || ! check_move<MAX_SIZE>(
@@ -870,8 +936,10 @@ void State::update_moves(Color c)
                 marker.clear(mv);
         }
     else
-        for (Move mv : moves)
+        for (unsigned i = 0; i < n; ++i)
         {
+            prefetch_move_info<MAX_SIZE>(moves, i + prefetch_distance);
+            auto mv = moves[i];
             auto& info = get_move_info<MAX_SIZE>(mv);
             if (! m_bd.is_piece_left(c, info.get_piece())
                     || ! check_move<MAX_SIZE>(
@@ -879,6 +947,44 @@ void State::update_moves(Color c)
                              total_gamma))
                 marker.clear(mv);
         }
+}
+
+#ifdef LIBPENTOBI_MCTS_SIMD_FEATURES
+template<unsigned MAX_SIZE>
+void State::update_old_moves_avx2(Color c, unsigned& nu_moves,
+                                  float& total_gamma)
+{
+    auto& playout_features = m_playout_features[c];
+    auto& marker = m_marker[c];
+    auto& moves = m_moves[c];
+    auto n = moves.size();
+    for (unsigned i = 0; i < n; ++i)
+    {
+        prefetch_move_info<MAX_SIZE>(moves, i + prefetch_distance);
+        auto mv = moves[i];
+        auto& info = get_move_info<MAX_SIZE>(mv);
+        auto piece = info.get_piece();
+        if (! m_bd.is_piece_left(c, piece)
+                || ! check_move(mv, playout_features.compute_avx2(info),
+                                m_gamma_piece[piece], moves, nu_moves,
+                                total_gamma))
+            marker.clear(mv);
+    }
+}
+#endif
+
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
+void State::update_moves(Color c)
+{
+    auto& playout_features = m_playout_features[c];
+    playout_features.set_local<MAX_SIZE, MAX_ADJ_ATTACH, IS_CALLISTO>(m_bd);
+
+    // Find old moves that are still legal
+    auto& is_forbidden = m_bd.is_forbidden(c);
+    auto& moves = m_moves[c];
+    unsigned nu_moves = 0;
+    float total_gamma = 0;
+    update_old_moves<MAX_SIZE>(c, nu_moves, total_gamma);
 
     // Find new legal moves because of new pieces played by this color
     auto& pieces = get_pieces_considered<IS_CALLISTO>(c);
@@ -18,6 +18,7 @@
 
 namespace libpentobi_mcts {
 
+using libboardgame_base::ArrayList;
 using libboardgame_base::RandomGenerator;
 using libboardgame_base::Statistics;
 using libboardgame_mcts::LastGoodReply;
@@ -44,7 +45,8 @@ class State
 {
 public:
     using Node =
-        libboardgame_mcts::Node<Move, Float, SearchParamConst::multithread>;
+        libboardgame_mcts::Node<Move, Float, SearchParamConst::multithread,
+                                SearchParamConst::pack_node_values>;
 
     using Tree = libboardgame_mcts::Tree<Node>;
 
@@ -56,6 +58,10 @@ public:
 
     using PlayerMove = libboardgame_mcts::PlayerMove<Move>;
 
+    /** Moves of a simulation.
+        Same type as SearchBase::Simulation::moves. */
+    using SimulationMoves = ArrayList<PlayerMove, SearchParamConst::max_moves>;
+
 
     /** Constructor.
         @param initial_variant Game variant to initialize the internal
@@ -80,6 +86,12 @@ public:
     /** Get current player to play. */
     PlayerInt get_player() const;
 
+    /** Hash code of the current in-tree position and player to play.
+        Only used if SearchParamConst::use_transpositions is true.
+        @return The hash code or 0 if a pass move was played in the current
+        position. */
+    uint_least64_t get_hash() const;
+
     void start_search();
 
     void start_simulation(size_t n);
@@ -88,19 +100,21 @@ public:
 
     void start_playout() { }
 
-    /** Generate a playout move.
-        @return @c false if end of game was reached, and no move was
-        generated. */
-    bool gen_playout_move(const LastGoodReply& lgr, Move last,
-                          Move second_last, PlayerMove& mv);
+    /** Generate and play the playout moves until the end of the game.
+        The moves are appended to the moves of the simulation. The playout
+        loop is instantiated for each type of move generation (piece size,
+        Callisto rules), so the game variant is checked only once per
+        playout and not for each move. */
+    void playout(const LastGoodReply& lgr, SimulationMoves& moves);
 
     void evaluate_playout(array<Float, 6>& result);
 
-    void play_playout(Move mv);
-
     /** Check if RAVE value for this move should not be updated. */
     bool skip_rave(Move mv) const;
 
+    /** Reseed the random generator used in the playouts. */
+    void set_seed(RandomGenerator::ResultType seed);
+
 #ifdef LIBBOARDGAME_DEBUG
     string dump() const;
 #endif
@@ -108,6 +122,11 @@ public:
     string get_info() const;
 
 private:
+    /** Number of moves that the move infos are prefetched ahead when
+        iterating over the move list. */
+    static constexpr unsigned prefetch_distance = 8;
+
+
     /** The cumulative gamma value of the moves in m_moves. */
     array<float, MoveList::max_size> m_cumulative_gamma;
 
@@ -202,6 +221,12 @@ private:
     /** Cache of m_bc->get_max_piece_size() */
     unsigned m_max_piece_size;
 
+    /** Maximum number of moves since the snapshot for restoring the snapshot
+        with restore_snapshot_delta().
+        If more moves were played, copying the state of all points is
+        faster. */
+    unsigned m_max_moves_restore_delta;
+
     /** Remember attach points that were already used for move generation.
         Allows the incremental update of the move lists to skip attach points
         of newly played pieces that were already attach points of previously
@@ -243,6 +268,11 @@ private:
     template<unsigned MAX_ADJ_ATTACH>
     const MoveInfoExt<MAX_ADJ_ATTACH>& get_move_info_ext(Move mv) const;
 
+    /** Prefetch the move info of a move in a move list.
+        Does nothing if the index is not smaller than the size of the list. */
+    template<unsigned MAX_SIZE>
+    void prefetch_move_info(const MoveList& moves, unsigned i) const;
+
     PrecompMoves::Range get_moves(Color c, Piece piece, Point p,
                                   unsigned adj_status) const;
 
@@ -255,6 +285,13 @@ private:
 
     void init_gamma();
 
+    /** Generate the move list for the playout phase.
+        The list is generated from the precomputed moves even if only a few
+        moves were played since the root position. Starting from a copy of
+        the move list of the root position was tried but was not faster,
+        because about half of the copied moves become illegal after the
+        in-tree moves and checking them costs as much as generating the moves
+        at the attach points. */
     template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
     void init_moves_with_gamma(Color c);
 
@@ -279,11 +316,52 @@ private:
                     const PlayoutFeatures& playout_features,
                     float& total_gamma);
 
+    bool check_move(Move mv, PlayoutFeatures::Compute features,
+                    float gamma_piece, MoveList& moves, unsigned& nu_moves,
+                    float& total_gamma);
+
+    /** Generate a playout move.
+        @return @c false if end of game was reached, and no move was
+        generated. */
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
+    bool gen_playout_move(const LastGoodReply& lgr, Move last,
+                          Move second_last, PlayerMove& mv);
+
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
     bool gen_playout_move_full(PlayerMove& mv);
 
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+    void play_playout(Move mv);
+
+    void play_playout(Move mv);
+
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
+    void playout(const LastGoodReply& lgr, SimulationMoves& moves);
+
+    /** Restore the snapshot of the board, the playout features and
+        m_moves_added_at by rolling back only the points changed since the
+        snapshot. */
+    template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
+    void restore_snapshot_delta();
+
     template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
     void update_moves(Color c);
 
+    /** Keep the moves from the last move generation that are still legal.
+        The remaining moves are moved to the beginning of the move list of the
+        color. */
+    template<unsigned MAX_SIZE>
+    void update_old_moves(Color c, unsigned& nu_moves, float& total_gamma);
+
+#ifdef LIBPENTOBI_MCTS_SIMD_FEATURES
+    /** Version of update_old_moves() using PlayoutFeatures::compute_avx2().
+        Used instead of update_old_moves() for large pieces. */
+    template<unsigned MAX_SIZE>
+    __attribute__((target("avx2")))
+    void update_old_moves_avx2(Color c, unsigned& nu_moves,
+                               float& total_gamma);
+#endif
+
     template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
     void update_playout_features(Color c, Move mv);
 
@@ -345,6 +423,7 @@ inline void State::finish_in_tree()
         m_is_symmetry_broken = check_symmetry_broken(m_bd);
 }
 
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH, bool IS_CALLISTO>
 inline bool State::gen_playout_move(const LastGoodReply& lgr, Move last,
                                     Move second_last, PlayerMove& mv)
 {
@@ -367,7 +446,7 @@ inline bool State::gen_playout_move(const LastGoodReply& lgr, Move last,
         mv = {player, lgr1};
         return true;
     }
-    return gen_playout_move_full(mv);
+    return gen_playout_move_full<MAX_SIZE, MAX_ADJ_ATTACH, IS_CALLISTO>(mv);
 }
 
 template<unsigned MAX_SIZE>
@@ -392,6 +471,15 @@ inline PrecompMoves::Range State::get_moves(Color c, Piece piece, Point p,
     return m_shared_const.precomp_moves[c].get_moves(piece, p, adj_status);
 }
 
+inline uint_least64_t State::get_hash() const
+{
+    if (m_nu_passes > 0)
+        return 0;
+    // The player in Variant::classic_3 does not need to be included
+    // because it is determined by the number of pieces left of Color(3)
+    return m_bd.get_hash();
+}
+
 inline PlayerInt State::get_player() const
 {
     unsigned player = m_bd.get_to_play().to_int();
@@ -441,43 +529,49 @@ inline void State::play_in_tree(Move mv)
     }
 }
 
+template<unsigned MAX_SIZE, unsigned MAX_ADJ_ATTACH>
 inline void State::play_playout(Move mv)
 {
     auto to_play = m_bd.get_to_play();
     LIBBOARDGAME_ASSERT(m_bd.is_legal(to_play, mv));
-    if (m_max_piece_size == 5)
-    {
-        m_bd.play<5, 16>(to_play, mv);
-        update_playout_features<5, 16>(to_play, mv);
-        if (! m_is_symmetry_broken)
-            update_symmetry_broken<5>(mv);
-    }
-    else if (m_max_piece_size == 6)
+    m_bd.play<MAX_SIZE, MAX_ADJ_ATTACH>(to_play, mv);
+    update_playout_features<MAX_SIZE, MAX_ADJ_ATTACH>(to_play, mv);
+    if constexpr (MAX_SIZE == 7)
     {
-        m_bd.play<6, 22>(to_play, mv);
-        update_playout_features<6, 22>(to_play, mv);
-        if (! m_is_symmetry_broken)
-            update_symmetry_broken<6>(mv);
-    }
-    else if (m_max_piece_size == 7)
-    {
-        m_bd.play<7, 12>(to_play, mv);
-        update_playout_features<7, 12>(to_play, mv);
         // No game variant with piece size 7 uses m_is_symmetry_broken
         LIBBOARDGAME_ASSERT(m_is_symmetry_broken);
     }
-    else
-    {
-        m_bd.play<22, 44>(to_play, mv);
-        update_playout_features<22, 44>(to_play, mv);
-        if (! m_is_symmetry_broken)
-            update_symmetry_broken<22>(mv);
-    }
+    else if (! m_is_symmetry_broken)
+        update_symmetry_broken<MAX_SIZE>(mv);
     ++m_nu_new_moves[to_play];
     m_last_move[to_play] = mv;
     m_nu_passes = 0;
 }
 
+inline void State::play_playout(Move mv)
+{
+    if (m_max_piece_size == 5)
+        play_playout<5, 16>(mv);
+    else if (m_max_piece_size == 6)
+        play_playout<6, 22>(mv);
+    else if (m_max_piece_size == 7)
+        play_playout<7, 12>(mv);
+    else
+        play_playout<22, 44>(mv);
+}
+
+template<unsigned MAX_SIZE>
+inline void State::prefetch_move_info(const MoveList& moves, unsigned i) const
+{
+    if (i < moves.size())
+        LIBBOARDGAME_PREFETCH(&get_move_info<MAX_SIZE>(moves[i]));
+}
+
+inline void State::set_seed(RandomGenerator::ResultType seed)
+{
+    m_random.set_seed(seed);
+}
+
 inline bool State::skip_rave([[maybe_unused]] Move mv) const
 {
     return false;
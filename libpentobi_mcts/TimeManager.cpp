@@ -0,0 +1,156 @@
+//-----------------------------------------------------------------------------
+/** @file libpentobi_mcts/TimeManager.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "TimeManager.h"
+
+#include <algorithm>
+
+namespace libpentobi_mcts {
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+void TimeManager::add_used_time(Color c, double time)
+{
+    auto& left = m_time_left[c];
+    auto& stones = m_stones_left[c];
+    switch (m_system)
+    {
+    case System::none:
+        return;
+    case System::absolute:
+        left = max(left - time, 0.);
+        return;
+    case System::fischer:
+        left = max(left - time, 0.) + m_period_time;
+        return;
+    case System::canadian:
+    case System::byoyomi:
+        break;
+    }
+    if (stones == 0)
+    {
+        left -= time;
+        if (left >= 0 || m_period_stones == 0)
+        {
+            left = max(left, 0.);
+            return;
+        }
+        // The move used up the main time, the rest of the move is played
+        // in the first period and counts as a move of the period
+        time = -left;
+        left = m_period_time;
+        stones = m_period_stones;
+    }
+    if (m_system == System::canadian)
+    {
+        left = max(left - time, 0.);
+        if (--stones == 0)
+        {
+            left = m_period_time;
+            stones = m_period_stones;
+        }
+    }
+    else
+    {
+        while (time > m_period_time && stones > 1)
+        {
+            time -= m_period_time;
+            --stones;
+        }
+        left = m_period_time;
+    }
+}
+
+void TimeManager::get_time(Color c, unsigned moves_left, double& time,
+                           double& max_time) const
+{
+    time = 0;
+    max_time = 0;
+    moves_left = max(moves_left, 1u);
+    auto left = max(m_time_left[c] - m_overhead, 0.);
+    auto stones = m_stones_left[c];
+    switch (m_system)
+    {
+    case System::none:
+        return;
+    case System::absolute:
+        time = min(left / moves_left, max_fraction * left);
+        max_time = min(max_extension * time, max_fraction * left);
+        break;
+    case System::fischer:
+        // The increments of the remaining moves except the last one can be
+        // spread over all remaining moves
+        time = (left + (moves_left - 1) * m_period_time) / moves_left;
+        time = min(time, max_fraction * left);
+        max_time = min(max_extension * time, max_fraction * left);
+        break;
+    case System::canadian:
+        if (stones == 0)
+        {
+            double period_move_time = 0;
+            if (m_period_stones > 0)
+                period_move_time =
+                        max(m_period_time - m_period_stones * m_overhead, 0.)
+                        / m_period_stones;
+            time = left / moves_left + period_move_time;
+            max_time = min(max_extension * time,
+                           max_fraction * left + period_move_time);
+        }
+        else
+        {
+            time = left / stones;
+            max_time = time;
+        }
+        break;
+    case System::byoyomi:
+        {
+            double period = 0;
+            if (m_period_stones > 0)
+                period = max(m_period_time - m_overhead, 0.);
+            if (stones == 0)
+            {
+                time = left / moves_left + period;
+                max_time = min(max_extension * time,
+                               max_fraction * left + period);
+            }
+            else
+            {
+                time = period;
+                max_time = period;
+            }
+        }
+        break;
+    }
+    max_time = max(max_time, time);
+}
+
+void TimeManager::init(System system, double main_time, double period_time,
+                       unsigned period_stones)
+{
+    m_system = system;
+    m_period_time = period_time;
+    m_period_stones = period_stones;
+    m_time_left.fill(main_time);
+    m_stones_left.fill(0);
+    if (main_time <= 0 && period_stones > 0
+            && (system == System::canadian || system == System::byoyomi))
+    {
+        m_time_left.fill(period_time);
+        m_stones_left.fill(period_stones);
+    }
+}
+
+void TimeManager::set_time_left(Color c, double time, unsigned stones)
+{
+    m_time_left[c] = time;
+    m_stones_left[c] = stones;
+}
+
+//-----------------------------------------------------------------------------
+
+} // namespace libpentobi_mcts
@@ -0,0 +1,115 @@
+//-----------------------------------------------------------------------------
+/** @file libpentobi_mcts/TimeManager.h
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#ifndef LIBPENTOBI_MCTS_TIME_MANAGER_H
+#define LIBPENTOBI_MCTS_TIME_MANAGER_H
+
+#include "libpentobi_base/ColorMap.h"
+
+namespace libpentobi_mcts {
+
+using libpentobi_base::Color;
+using libpentobi_base::ColorMap;
+
+//-----------------------------------------------------------------------------
+
+/** Time management for games played with a game clock.
+    Stores the time settings and the remaining time of each color and
+    computes the time for the next move. The remaining time is updated
+    after each move with the used time but should be set with
+    set_time_left() if the controller knows the exact clock values (e.g.
+    from the GTP command time_left). */
+class TimeManager
+{
+public:
+    enum class System
+    {
+        /** No time limit. */
+        none,
+
+        /** Main time only (sudden death). */
+        absolute,
+
+        /** Main time followed by periods of period_time.
+            A period is lost if a move takes longer than period_time. */
+        byoyomi,
+
+        /** Main time followed by periods of period_time for period_stones
+            moves. */
+        canadian,
+
+        /** Main time, period_time is added after each move. */
+        fischer
+    };
+
+    /** Set the time settings and reset the clocks of all colors.
+        @param system
+        @param main_time
+        @param period_time The byo-yomi time or the Fischer increment.
+        @param period_stones The number of moves in a Canadian byo-yomi
+        period or the number of periods in Japanese byo-yomi. */
+    void init(System system, double main_time, double period_time = 0,
+              unsigned period_stones = 0);
+
+    bool is_enabled() const { return m_system != System::none; }
+
+    System get_system() const { return m_system; }
+
+    /** Set the remaining time of a color.
+        @param c
+        @param time The remaining main time if stones is 0, otherwise the
+        remaining time in the current byo-yomi period.
+        @param stones 0 if the color is in the main time, otherwise the
+        number of moves left in the current Canadian byo-yomi period or the
+        number of Japanese byo-yomi periods left. */
+    void set_time_left(Color c, double time, unsigned stones);
+
+    double get_time_left(Color c) const { return m_time_left[c]; }
+
+    unsigned get_stones_left(Color c) const { return m_stones_left[c]; }
+
+    /** Update the clock of a color after a move. */
+    void add_used_time(Color c, double time);
+
+    /** Get the time for the next move.
+        @param c
+        @param moves_left The expected number of remaining moves of the color
+        including the next move.
+        @param[out] time The time that the search should normally use.
+        @param[out] max_time The maximum time if the search is extended
+        because the best move is unstable. Not less than time. */
+    void get_time(Color c, unsigned moves_left, double& time,
+                  double& max_time) const;
+
+    /** Time reserved per move for the communication with the controller.
+        Default is 0.1 s. */
+    void set_overhead(double time) { m_overhead = time; }
+
+private:
+    /** Maximum factor for extending the normal time of a move. */
+    static constexpr double max_extension = 3;
+
+    /** Maximum fraction of the remaining main time used for a move. */
+    static constexpr double max_fraction = 0.5;
+
+    System m_system = System::none;
+
+    double m_period_time = 0;
+
+    unsigned m_period_stones = 0;
+
+    double m_overhead = 0.1;
+
+    ColorMap<double> m_time_left{0.};
+
+    ColorMap<unsigned> m_stones_left{0u};
+};
+
+//-----------------------------------------------------------------------------
+
+} // namespace libpentobi_mcts
+
+#endif // LIBPENTOBI_MCTS_TIME_MANAGER_H
@@ -0,0 +1,72 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libpentobi_mcts/PlayoutFeaturesTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libpentobi_mcts/PlayoutFeatures.h"
+
+#include "libboardgame_test/Test.h"
+#include "libpentobi_base/MoveMarker.h"
+
+using namespace std;
+using namespace libpentobi_mcts;
+using libpentobi_base::MoveList;
+using libpentobi_base::MoveMarker;
+
+//-----------------------------------------------------------------------------
+
+/** Check that PlayoutFeatures::compute_avx2() computes the same feature
+    values as PlayoutFeatures::Compute for all moves. */
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_playout_features_compute_avx2)
+{
+#ifdef LIBPENTOBI_MCTS_SIMD_FEATURES
+    if (! PlayoutFeatures::is_avx2_supported())
+        return;
+    auto bd = make_unique<Board>(Variant::gembloq_2);
+    auto moves = make_unique<MoveList>();
+    auto marker = make_unique<MoveMarker>();
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        auto c = bd->get_to_play();
+        bd->gen_moves(c, *marker, *moves);
+        marker->clear(*moves);
+        if (moves->empty())
+            break;
+        bd->play(c, (*moves)[moves->size() / 2]);
+    }
+    auto& bc = bd->get_board_const();
+    auto move_info_array = bc.get_move_info_array();
+    auto playout_features = make_unique<PlayoutFeatures>();
+    playout_features->init_snapshot(*bd, bd->get_to_play());
+    playout_features->restore_snapshot(*bd);
+    playout_features->set_local<22, 44, false>(*bd);
+    unsigned nu_forbidden = 0;
+    unsigned nu_local = 0;
+    for (Move::IntType i = 1; i < bc.get_range(); ++i)
+    {
+        auto& info = BoardConst::get_move_info<22>(Move(i), move_info_array);
+        auto p = info.begin();
+        PlayoutFeatures::Compute features(*p, *playout_features);
+        for (unsigned j = 1; j < 22; ++j)
+            features.add(*(++p), *playout_features);
+        auto features_avx2 = playout_features->compute_avx2(info);
+        LIBBOARDGAME_CHECK_EQUAL(features.is_forbidden(),
+                                 features_avx2.is_forbidden());
+        if (features.is_forbidden())
+        {
+            ++nu_forbidden;
+            continue;
+        }
+        LIBBOARDGAME_CHECK_EQUAL(features.get_nu_local(),
+                                 features_avx2.get_nu_local());
+        if (features.get_nu_local() > 0)
+            ++nu_local;
+    }
+    // Make sure that the test covers both features
+    LIBBOARDGAME_CHECK(nu_forbidden > 0);
+    LIBBOARDGAME_CHECK(nu_local > 0);
+#endif
+}
+
+//-----------------------------------------------------------------------------
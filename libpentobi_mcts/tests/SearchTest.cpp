@@ -6,10 +6,11 @@
 
 #include "libpentobi_mcts/Search.h"
 
+#include "libboardgame_base/CpuAffinity.h"
+#include "libboardgame_base/CpuTimeSource.h"
 #include "libboardgame_base/SgfUtil.h"
 #include "libboardgame_base/TreeReader.h"
 #include "libboardgame_test/Test.h"
-#include "libboardgame_base/CpuTimeSource.h"
 #include "libpentobi_base/BoardUpdater.h"
 #include "libpentobi_base/PentobiTree.h"
 
@@ -19,6 +20,7 @@ using libboardgame_base::CpuTimeSource;
 using libboardgame_base::SgfNode;
 using libboardgame_base::TreeReader;
 using libboardgame_base::get_last_node;
+using libboardgame_base::get_thread_cpus;
 using libpentobi_base::BoardUpdater;
 using libpentobi_base::PentobiTree;
 
@@ -106,4 +108,114 @@ LIBBOARDGAME_TEST_CASE(pentobi_mcts_search_callisto_useless_one_piece)
     LIBBOARDGAME_CHECK(bd->get_move_piece(mv) == bd->get_one_piece());
 }
 
+/** Test that a search after a stop request does not reuse the tree of an
+    unrelated position.
+    This tests for a bug in the first implementation of pondering: the abort
+    state was left set after the ponder search was stopped, which made the
+    next search reuse the whole old tree. */
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_search_no_reuse_after_stop)
+{
+    auto bd = make_unique<Board>(Variant::duo);
+    unsigned nu_threads = 1;
+    size_t memory = 100000000;
+    Float max_count = 100;
+    size_t min_simulations = 100;
+    double max_time = 0;
+    CpuTimeSource time_source;
+    Move mv;
+    bool res = make_unique<Search>(bd->get_variant(), nu_threads, memory)
+            ->search(mv, *bd, Color(0), max_count, min_simulations, max_time,
+                     time_source);
+    LIBBOARDGAME_CHECK(res);
+    bd->play(Color(0), mv);
+    auto search = make_unique<Search>(bd->get_variant(), nu_threads, memory);
+    res = search->search(mv, *bd, Color(1), 10 * max_count, min_simulations,
+                         max_time, time_source);
+    LIBBOARDGAME_CHECK(res);
+    search->request_stop();
+    search->clear_stop_request();
+    LIBBOARDGAME_CHECK(! search->was_aborted());
+    bd->init();
+    res = search->search(mv, *bd, Color(0), max_count, min_simulations,
+                         max_time, time_source);
+    LIBBOARDGAME_CHECK(res);
+    LIBBOARDGAME_CHECK(search->get_tree().get_root().get_visit_count()
+                       < 2 * max_count);
+}
+
+/** Test that the search stops early if the confidence bounds of the best
+    move and the second best move are separated.
+    Uses a very small confidence factor, such that the bounds are separated
+    as soon as the value counts are large enough. */
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_search_early_stop)
+{
+    auto bd = make_unique<Board>(Variant::duo);
+    unsigned nu_threads = 1;
+    size_t memory = 100000000;
+    auto search = make_unique<Search>(bd->get_variant(), nu_threads, memory);
+    search->set_early_stop_confidence(0.001f);
+    Float max_count = 100000;
+    size_t min_simulations = 0;
+    double max_time = 0;
+    CpuTimeSource time_source;
+    Move mv;
+    bool res = search->search(mv, *bd, Color(0), max_count, min_simulations,
+                              max_time, time_source);
+    LIBBOARDGAME_CHECK(res);
+    LIBBOARDGAME_CHECK(static_cast<Float>(search->get_nu_simulations())
+                       < max_count);
+    LIBBOARDGAME_CHECK(search->get_saved_simulations() > 0);
+}
+
+/** Test that the statistics of the root children are merged if the search
+    uses several trees. */
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_search_nu_trees)
+{
+    auto bd = make_unique<Board>(Variant::duo);
+    unsigned nu_threads = 2;
+    size_t memory = 100000000;
+    auto search = make_unique<Search>(bd->get_variant(), nu_threads, memory);
+    search->set_nu_trees(2);
+    Float max_count = 1000;
+    size_t min_simulations = 1000;
+    double max_time = 0;
+    CpuTimeSource time_source;
+    Move mv;
+    bool res = search->search(mv, *bd, Color(0), max_count, min_simulations,
+                              max_time, time_source);
+    LIBBOARDGAME_CHECK(res);
+    LIBBOARDGAME_CHECK(! mv.is_null());
+    auto& tree = search->get_tree();
+    auto count = tree.get_root().get_visit_count();
+    LIBBOARDGAME_CHECK(count >= max_count);
+    Float sum = 0;
+    for (auto& child : tree.get_root_children())
+        sum += child.get_visit_count();
+    // Allow for lost updates in the lock-free search
+    LIBBOARDGAME_CHECK(abs(sum - count) < 0.01f * count);
+}
+
+/** Test a search with threads bound to CPUs.
+    The CPU affinity of the calling thread must be restored after the
+    search. */
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_search_pin_threads)
+{
+    auto bd = make_unique<Board>(Variant::duo);
+    unsigned nu_threads = 2;
+    size_t memory = 100000000;
+    auto search = make_unique<Search>(bd->get_variant(), nu_threads, memory);
+    search->set_pin_threads(true);
+    auto cpus = get_thread_cpus();
+    Float max_count = 1000;
+    size_t min_simulations = 1000;
+    double max_time = 0;
+    CpuTimeSource time_source;
+    Move mv;
+    bool res = search->search(mv, *bd, Color(0), max_count, min_simulations,
+                              max_time, time_source);
+    LIBBOARDGAME_CHECK(res);
+    LIBBOARDGAME_CHECK(! mv.is_null());
+    LIBBOARDGAME_CHECK(get_thread_cpus() == cpus);
+}
+
 //-----------------------------------------------------------------------------
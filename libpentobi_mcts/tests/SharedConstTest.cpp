@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libpentobi_mcts/SharedConstTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libpentobi_mcts/SharedConst.h"
+
+#include "libboardgame_test/Test.h"
+
+using namespace std;
+using namespace libpentobi_mcts;
+using libpentobi_base::MoveList;
+using libpentobi_base::Piece;
+using libpentobi_base::Variant;
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+void play_moves(Board& bd, unsigned nu_moves)
+{
+    auto moves = make_unique<MoveList>();
+    auto marker = make_unique<MoveMarker>();
+    for (unsigned i = 0; i < nu_moves; ++i)
+    {
+        auto c = bd.get_to_play();
+        bd.gen_moves(c, *marker, *moves);
+        marker->clear(*moves);
+        if (moves->empty())
+            bd.set_to_play(bd.get_next(c));
+        else
+            bd.play(c, (*moves)[moves->size() / 3]);
+    }
+}
+
+/** Check that the update of the precomputed moves in follow-up positions
+    gives the same lists as the initialization from scratch. */
+void test_followup(Variant variant)
+{
+    auto bd = make_unique<Board>(variant);
+    Color to_play(0);
+    auto shared_const = make_unique<SharedConst>(to_play);
+    auto shared_const_full = make_unique<SharedConst>(to_play);
+    shared_const->board = bd.get();
+    shared_const_full->board = bd.get();
+    play_moves(*bd, bd->get_nu_colors());
+    shared_const->init(false);
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        play_moves(*bd, i + 1);
+        shared_const->init(true);
+        shared_const_full->init(false);
+        for (Color c : bd->get_colors())
+            for (Point p : *bd)
+            {
+                if (! bd->get_point_state(p).is_empty()
+                        || ! bd->get_board_const().has_adj_status_points(p)
+                        || bd->is_forbidden(p, c))
+                    continue;
+                auto adj_status = bd->get_adj_status(p, c);
+                for (unsigned j = 0; j < PrecompMoves::nu_adj_status; ++j)
+                {
+                    if ((j & adj_status) != adj_status)
+                        continue;
+                    for (Piece piece : bd->get_pieces_left(c))
+                    {
+                        auto& precomp = shared_const->precomp_moves[c];
+                        auto& precomp_full =
+                                shared_const_full->precomp_moves[c];
+                        LIBBOARDGAME_CHECK_EQUAL(
+                                    precomp.has_moves(piece, p, j),
+                                    precomp_full.has_moves(piece, p, j));
+                        auto moves = precomp.get_moves(piece, p, j);
+                        auto moves_full = precomp_full.get_moves(piece, p, j);
+                        LIBBOARDGAME_CHECK(equal(moves.begin(), moves.end(),
+                                                 moves_full.begin(),
+                                                 moves_full.end()));
+                    }
+                }
+            }
+    }
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_shared_const_followup)
+{
+    test_followup(Variant::duo);
+    test_followup(Variant::trigon_2);
+    test_followup(Variant::nexos_2);
+    test_followup(Variant::callisto_2);
+}
+
+//-----------------------------------------------------------------------------
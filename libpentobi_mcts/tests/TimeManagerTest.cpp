@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+/** @file unittest/libpentobi_mcts/TimeManagerTest.cpp
+    @author Markus Enzenberger
+    @copyright GNU General Public License version 3 or later */
+//-----------------------------------------------------------------------------
+
+#include "libpentobi_mcts/TimeManager.h"
+
+#include "libboardgame_test/Test.h"
+
+using namespace std;
+using namespace libpentobi_mcts;
+
+//-----------------------------------------------------------------------------
+
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_time_manager_absolute)
+{
+    TimeManager time_manager;
+    time_manager.set_overhead(0);
+    time_manager.init(TimeManager::System::absolute, 100);
+    LIBBOARDGAME_CHECK(time_manager.is_enabled());
+    double time;
+    double max_time;
+    time_manager.get_time(Color(0), 10, time, max_time);
+    LIBBOARDGAME_CHECK_CLOSE(time, 10., 1e-6);
+    LIBBOARDGAME_CHECK_CLOSE(max_time, 30., 1e-6);
+    // Never use more than half of the remaining time for a move
+    time_manager.get_time(Color(0), 1, time, max_time);
+    LIBBOARDGAME_CHECK_CLOSE(time, 50., 1e-6);
+    LIBBOARDGAME_CHECK_CLOSE(max_time, 50., 1e-6);
+    time_manager.add_used_time(Color(0), 30);
+    LIBBOARDGAME_CHECK_CLOSE(time_manager.get_time_left(Color(0)), 70.,
+                             1e-6);
+    LIBBOARDGAME_CHECK_CLOSE(time_manager.get_time_left(Color(1)), 100.,
+                             1e-6);
+}
+
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_time_manager_canadian)
+{
+    TimeManager time_manager;
+    time_manager.set_overhead(0);
+    time_manager.init(TimeManager::System::canadian, 10, 30, 3);
+    double time;
+    double max_time;
+    time_manager.get_time(Color(0), 10, time, max_time);
+    LIBBOARDGAME_CHECK_CLOSE(time, 11., 1e-6);
+    // Use up the main time and continue in the first period, the move counts
+    // as a move of the period
+    time_manager.add_used_time(Color(0), 15);
+    LIBBOARDGAME_CHECK_EQUAL(time_manager.get_stones_left(Color(0)), 2u);
+    LIBBOARDGAME_CHECK_CLOSE(time_manager.get_time_left(Color(0)), 25.,
+                             1e-6);
+    time_manager.get_time(Color(0), 10, time, max_time);
+    LIBBOARDGAME_CHECK_CLOSE(time, 12.5, 1e-6);
+    LIBBOARDGAME_CHECK_CLOSE(max_time, time, 1e-6);
+    time_manager.add_used_time(Color(0), 5);
+    LIBBOARDGAME_CHECK_EQUAL(time_manager.get_stones_left(Color(0)), 1u);
+    // The last move of a period starts a new period
+    time_manager.add_used_time(Color(0), 5);
+    LIBBOARDGAME_CHECK_EQUAL(time_manager.get_stones_left(Color(0)), 3u);
+    LIBBOARDGAME_CHECK_CLOSE(time_manager.get_time_left(Color(0)), 30.,
+                             1e-6);
+}
+
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_time_manager_fischer)
+{
+    TimeManager time_manager;
+    time_manager.set_overhead(0);
+    time_manager.init(TimeManager::System::fischer, 60, 5);
+    double time;
+    double max_time;
+    time_manager.get_time(Color(0), 11, time, max_time);
+    LIBBOARDGAME_CHECK_CLOSE(time, 10., 1e-6);
+    LIBBOARDGAME_CHECK_CLOSE(max_time, 30., 1e-6);
+    time_manager.add_used_time(Color(0), 10);
+    LIBBOARDGAME_CHECK_CLOSE(time_manager.get_time_left(Color(0)), 55.,
+                             1e-6);
+    time_manager.set_time_left(Color(0), 4, 0);
+    time_manager.get_time(Color(0), 11, time, max_time);
+    LIBBOARDGAME_CHECK(max_time <= 2);
+}
+
+LIBBOARDGAME_TEST_CASE(pentobi_mcts_time_manager_none)
+{
+    TimeManager time_manager;
+    LIBBOARDGAME_CHECK(! time_manager.is_enabled());
+    time_manager.init(TimeManager::System::absolute, 100);
+    time_manager.init(TimeManager::System::none, 0);
+    LIBBOARDGAME_CHECK(! time_manager.is_enabled());
+}
+
+//-----------------------------------------------------------------------------
@@ -6,15 +6,112 @@
 
 #include "GtpEngine.h"
 
+#include <atomic>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include "libboardgame_base/Log.h"
+#include "libboardgame_base/RandomGenerator.h"
 #include "libboardgame_base/Writer.h"
 #include "libpentobi_mcts/Util.h"
 
+using libboardgame_base::RandomGenerator;
 using libboardgame_base::Writer;
+using libboardgame_base::disable_logging;
+using libboardgame_base::get_log_stream;
+using libboardgame_base::set_log_stream;
 using libboardgame_gtp::Failure;
 using libpentobi_base::Board;
 using libpentobi_base::get_color_id;
 using libpentobi_mcts::Float;
+using libpentobi_mcts::TimeManager;
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+/** Copy the settings that are relevant for self-play games to another
+    player.
+    The number of threads and the tree memory are set when the player is
+    created. The search parameter pin_threads is not copied because the
+    threads of concurrent players would all be bound to the same CPUs. */
+void copy_settings(Player& from, Player& to)
+{
+    to.set_level(from.get_level());
+    if (from.get_fixed_time() > 0)
+        to.set_fixed_time(from.get_fixed_time());
+    else
+        to.set_fixed_simulations(from.get_fixed_simulations());
+    for (unsigned i = 1; i <= Player::max_supported_level; ++i)
+        to.set_early_stop_confidence(i, from.get_early_stop_confidence(i));
+    to.set_use_book(from.get_use_book());
+    auto& s_from = from.get_search();
+    auto& s_to = to.get_search();
+    s_to.set_avoid_symmetric_draw(s_from.get_avoid_symmetric_draw());
+    s_to.set_exploration_constant(s_from.get_exploration_constant());
+    s_to.set_nu_trees(s_from.get_nu_trees());
+    s_to.set_rave_child_max(s_from.get_rave_child_max());
+    s_to.set_rave_parent_max(s_from.get_rave_parent_max());
+    s_to.set_rave_weight(s_from.get_rave_weight());
+    s_to.set_reuse_subtree(s_from.get_reuse_subtree());
+    s_to.set_simd_select(s_from.get_simd_select());
+}
+
+/** Play a self-play game.
+    @param player
+    @param bd The board to play the game on.
+    @param random Random generator for selecting the type of search.
+    @param full_probability
+    @param fast_simulations The number of simulations of a fast search or
+    0 to use the normal search for all moves.
+    @return The game in SGF format.
+    @see GtpEngine::cmd_selfplay() */
+string play_selfplay_game(Player& player, Board& bd, RandomGenerator& random,
+                          double full_probability, Float fast_simulations)
+{
+    bool use_playout_cap = (fast_simulations > 0);
+    auto variant = bd.get_variant();
+    auto fixed_simulations = player.get_fixed_simulations();
+    auto fixed_time = player.get_fixed_time();
+    ostringstream s;
+    Writer writer(s);
+    writer.set_indent(-1);
+    bd.init();
+    writer.begin_tree();
+    writer.begin_node();
+    writer.write_property("GM", to_string(variant));
+    writer.end_node();
+    while (! bd.is_game_over())
+    {
+        auto c = bd.get_effective_to_play();
+        bool is_full =
+                (! use_playout_cap
+                 || random.generate_double(0, 1) < full_probability);
+        if (! is_full)
+            player.set_fixed_simulations(fast_simulations);
+        auto mv = player.genmove(bd, c);
+        if (! is_full)
+        {
+            // Restore the budget of the full search
+            if (fixed_time > 0)
+                player.set_fixed_time(fixed_time);
+            else
+                player.set_fixed_simulations(fixed_simulations);
+        }
+        bd.play(c, mv);
+        writer.begin_node();
+        writer.write_property(get_color_id(variant, c),
+                              bd.to_string(mv, false));
+        // Moves from the opening book were not searched
+        if (use_playout_cap && ! player.is_book_move())
+            writer.write_property("PC", is_full ? "full" : "fast");
+        writer.end_node();
+    }
+    writer.end_tree();
+    return s.str();
+}
+
+} // namespace
 
 //-----------------------------------------------------------------------------
 
@@ -26,11 +123,14 @@ GtpEngine::GtpEngine(
     create_player(variant, level, books_dir, nu_threads);
     get_mcts_player().set_use_book(use_book);
     add("get_value", &GtpEngine::cmd_get_value);
+    add("kgs-time_settings", &GtpEngine::cmd_kgs_time_settings);
     add("name", &GtpEngine::cmd_name);
     add("param", &GtpEngine::cmd_param);
     add("move_values", &GtpEngine::cmd_move_values);
     add("save_tree", &GtpEngine::cmd_save_tree);
     add("selfplay", &GtpEngine::cmd_selfplay);
+    add("time_left", &GtpEngine::cmd_time_left);
+    add("time_settings", &GtpEngine::cmd_time_settings);
     add("version", &GtpEngine::cmd_version);
 }
 
@@ -41,6 +141,45 @@ void GtpEngine::cmd_get_value(Response& response)
     response << get_search().get_tree().get_root().get_value();
 }
 
+/** Set the time settings.
+    Supports the types of the KGS extension (none, absolute, byoyomi,
+    canadian) and additionally fischer with the arguments main time and
+    increment. */
+void GtpEngine::cmd_kgs_time_settings(Arguments args)
+{
+    auto& time_manager = get_mcts_player().get_time_manager();
+    auto type = args.get(0);
+    if (type == "none")
+    {
+        args.check_size(1);
+        time_manager.init(TimeManager::System::none, 0);
+    }
+    else if (type == "absolute")
+    {
+        args.check_size(2);
+        time_manager.init(TimeManager::System::absolute,
+                          args.get_min<double>(1, 0));
+    }
+    else if (type == "byoyomi" || type == "canadian")
+    {
+        args.check_size(4);
+        time_manager.init(type == "byoyomi" ? TimeManager::System::byoyomi
+                                            : TimeManager::System::canadian,
+                          args.get_min<double>(1, 0),
+                          args.get_min<double>(2, 0),
+                          args.get<unsigned>(3));
+    }
+    else if (type == "fischer")
+    {
+        args.check_size(3);
+        time_manager.init(TimeManager::System::fischer,
+                          args.get_min<double>(1, 0),
+                          args.get_min<double>(2, 0));
+    }
+    else
+        throw Failure("unknown time system '" + string(type) + "'");
+}
+
 void GtpEngine::cmd_move_values(Response& response)
 {
     auto children = get_search().get_tree().get_root_children();
@@ -78,40 +217,106 @@ void GtpEngine::cmd_save_tree(Arguments args)
     This is more efficient than using twogtp if selfplay games are needed
     because it has lower memory requirements (only one engine needed), process
     switches between the engines are avoided and parts of the search tree can
-    be reused between moves of different players. */
+    be reused between moves of different players.
+    Arguments: number of games, file name and optionally the probability of a
+    full search and the number of simulations of a fast search. With the
+    optional arguments, the games use playout cap randomization: each move is
+    generated with the normal search budget of the player with the given
+    probability and with the given fixed number of simulations otherwise. The
+    type of the search is stored in the private SGF property PC (value full or
+    fast), such that training data can be taken only from positions that were
+    searched with the full budget. Moves from the opening book have no PC
+    property.
+    If the parameter selfplay_games is greater than 1, this number of games
+    is played concurrently. Each concurrent game uses its own player with the
+    settings of the current player (except pin_threads), selfplay_threads
+    search threads (0 means to split the threads of the current player
+    evenly) and an equal share of the tree memory. The games are written to
+    the file in the order they finish. Logging is disabled while the
+    concurrent games are played because the output of the games would be
+    interleaved. */
 void GtpEngine::cmd_selfplay(Arguments args)
 {
-    args.check_size(2);
+    if (args.get_size() != 2)
+        args.check_size(4);
     auto nu_games = args.get<int>(0);
     ofstream out(args.get<string>(1));
+    double full_probability = 1;
+    Float fast_simulations = 0;
+    if (args.get_size() == 4)
+    {
+        full_probability = args.get_min<double>(2, 0);
+        if (full_probability > 1)
+            throw Failure("probability must be less or equal 1");
+        fast_simulations = args.get_min<Float>(3, 1);
+    }
     auto variant = get_board().get_variant();
-    auto variant_str = to_string(variant);
-    Board bd(variant);
     auto& player = get_mcts_player();
-    ostringstream s;
-    for (int i = 0; i < nu_games; ++i)
+    RandomGenerator random;
+    auto nu_parallel = static_cast<unsigned>(
+                max(min(static_cast<int>(m_selfplay_games), nu_games), 1));
+    if (nu_parallel == 1)
     {
-        s.str("");
-        Writer writer(s);
-        writer.set_indent(-1);
-        bd.init();
-        writer.begin_tree();
-        writer.begin_node();
-        writer.write_property("GM", variant_str);
-        writer.end_node();
-        while (! bd.is_game_over())
-        {
-            auto c = bd.get_effective_to_play();
-            auto mv = player.genmove(bd, c);
-            bd.play(c, mv);
-            writer.begin_node();
-            writer.write_property(get_color_id(variant, c),
-                                  bd.to_string(mv, false));
-            writer.end_node();
-        }
-        writer.end_tree();
-        out << s.str() << '\n';
+        Board bd(variant);
+        for (int i = 0; i < nu_games; ++i)
+            out << play_selfplay_game(player, bd, random, full_probability,
+                                      fast_simulations) << '\n';
+        return;
     }
+    auto nu_threads = m_selfplay_threads;
+    if (nu_threads == 0)
+        nu_threads = max(player.get_search().get_nu_threads() / nu_parallel,
+                         1u);
+    auto memory = Player::get_default_memory(m_max_level) / nu_parallel;
+    vector<unique_ptr<Player>> players;
+    vector<unique_ptr<RandomGenerator>> randoms;
+    for (unsigned i = 0; i < nu_parallel; ++i)
+    {
+        auto p = make_unique<Player>(variant, m_max_level, m_books_dir,
+                                     nu_threads, memory);
+        copy_settings(player, *p);
+        // Without a different seed, all games would be the same if a global
+        // seed was set
+        p->set_seed(random.generate());
+        players.push_back(move(p));
+        randoms.push_back(make_unique<RandomGenerator>());
+        randoms.back()->set_seed(random.generate());
+    }
+    auto log_stream = get_log_stream();
+    disable_logging();
+    atomic<int> next_game(0);
+    mutex out_mutex;
+    exception_ptr error;
+    vector<thread> threads;
+    for (unsigned i = 0; i < nu_parallel; ++i)
+        threads.emplace_back([&, i]
+        {
+            try
+            {
+                Board bd(variant);
+                while (next_game++ < nu_games)
+                {
+                    auto game = play_selfplay_game(*players[i], bd,
+                                                   *randoms[i],
+                                                   full_probability,
+                                                   fast_simulations);
+                    lock_guard lock(out_mutex);
+                    out << game << '\n' << flush;
+                }
+            }
+            catch (...)
+            {
+                lock_guard lock(out_mutex);
+                if (! error)
+                    error = current_exception();
+                next_game = nu_games;
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+    set_log_stream(log_stream);
+    if (error)
+        rethrow_exception(error);
 }
 
 void GtpEngine::cmd_param(Arguments args, Response& response)
@@ -121,12 +326,20 @@ void GtpEngine::cmd_param(Arguments args, Response& response)
     if (args.get_size() == 0)
         response
             << "avoid_symmetric_draw " << s.get_avoid_symmetric_draw() << '\n'
+            << "early_stop_confidence "
+            << p.get_early_stop_confidence(p.get_level()) << '\n'
             << "exploration_constant " << s.get_exploration_constant() << '\n'
             << "fixed_simulations " << p.get_fixed_simulations() << '\n'
+            << "fixed_time " << p.get_fixed_time() << '\n'
+            << "nu_trees " << s.get_nu_trees() << '\n'
+            << "pin_threads " << s.get_pin_threads() << '\n'
             << "rave_child_max " << s.get_rave_child_max() << '\n'
             << "rave_parent_max " << s.get_rave_parent_max() << '\n'
             << "rave_weight " << s.get_rave_weight() << '\n'
             << "reuse_subtree " << s.get_reuse_subtree() << '\n'
+            << "selfplay_games " << m_selfplay_games << '\n'
+            << "selfplay_threads " << m_selfplay_threads << '\n'
+            << "simd_select " << s.get_simd_select() << '\n'
             << "use_book " << p.get_use_book() << '\n';
     else
     {
@@ -134,10 +347,24 @@ void GtpEngine::cmd_param(Arguments args, Response& response)
         auto name = args.get(0);
         if (name == "avoid_symmetric_draw")
             s.set_avoid_symmetric_draw(args.get<bool>(1));
+        else if (name == "early_stop_confidence")
+            p.set_early_stop_confidence(p.get_level(),
+                                        args.get_min<Float>(1, 0));
         else if (name == "exploration_constant")
             s.set_exploration_constant(args.get<Float>(1));
         else if (name == "fixed_simulations")
             p.set_fixed_simulations(args.get<Float>(1));
+        else if (name == "fixed_time")
+            p.set_fixed_time(args.get<double>(1));
+        else if (name == "nu_trees")
+        {
+            auto n = args.get<unsigned>(1);
+            if (n == 0)
+                throw Failure("number of trees must be greater zero");
+            s.set_nu_trees(n);
+        }
+        else if (name == "pin_threads")
+            s.set_pin_threads(args.get<bool>(1));
         else if (name == "rave_child_max")
             s.set_rave_child_max(args.get<Float>(1));
         else if (name == "rave_parent_max")
@@ -146,6 +373,12 @@ void GtpEngine::cmd_param(Arguments args, Response& response)
             s.set_rave_weight(args.get<Float>(1));
         else if (name == "reuse_subtree")
             s.set_reuse_subtree(args.get<bool>(1));
+        else if (name == "selfplay_games")
+            m_selfplay_games = args.get_min<unsigned>(1, 1);
+        else if (name == "selfplay_threads")
+            m_selfplay_threads = args.get<unsigned>(1);
+        else if (name == "simd_select")
+            s.set_simd_select(args.get<bool>(1));
         else if (name == "use_book")
             p.set_use_book(args.get<bool>(1));
         else
@@ -157,6 +390,33 @@ void GtpEngine::cmd_param(Arguments args, Response& response)
     }
 }
 
+void GtpEngine::cmd_time_left(Arguments args)
+{
+    args.check_size(3);
+    get_mcts_player().get_time_manager().set_time_left(
+                get_color_arg(args, 0), args.get_min<double>(1, 0),
+                args.get<unsigned>(2));
+}
+
+/** Set the time settings as in the GTP standard.
+    A byo-yomi time greater than zero with zero byo-yomi stones means no
+    time limit, a byo-yomi time of zero means sudden death. */
+void GtpEngine::cmd_time_settings(Arguments args)
+{
+    args.check_size(3);
+    auto main_time = args.get_min<double>(0, 0);
+    auto byo_yomi_time = args.get_min<double>(1, 0);
+    auto byo_yomi_stones = args.get<unsigned>(2);
+    auto& time_manager = get_mcts_player().get_time_manager();
+    if (byo_yomi_time > 0 && byo_yomi_stones == 0)
+        time_manager.init(TimeManager::System::none, 0);
+    else if (byo_yomi_time == 0)
+        time_manager.init(TimeManager::System::absolute, main_time);
+    else
+        time_manager.init(TimeManager::System::canadian, main_time,
+                          byo_yomi_time, byo_yomi_stones);
+}
+
 void GtpEngine::cmd_version(Response& response)
 {
     string version;
@@ -175,6 +435,8 @@ void GtpEngine::create_player(Variant variant, unsigned level,
                            const string& books_dir, unsigned nu_threads)
 {
     auto max_level = level;
+    m_books_dir = books_dir;
+    m_max_level = max_level;
     m_player = make_unique<Player>(variant, max_level, books_dir, nu_threads);
     get_mcts_player().set_level(level);
     set_player(*m_player);
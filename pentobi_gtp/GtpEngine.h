@@ -32,10 +32,13 @@ public:
 
     void cmd_param(Arguments args, Response& response);
     void cmd_get_value(Response& response);
+    void cmd_kgs_time_settings(Arguments args);
     void cmd_move_values(Response& response);
     void cmd_name(Response& response);
     void cmd_selfplay(Arguments args);
     void cmd_save_tree(Arguments args);
+    void cmd_time_left(Arguments args);
+    void cmd_time_settings(Arguments args);
     void cmd_version(Response& response);
 
     Player& get_mcts_player();
@@ -46,6 +49,17 @@ public:
 private:
     unique_ptr<PlayerBase> m_player;
 
+    string m_books_dir;
+
+    unsigned m_max_level = 0;
+
+    /** Number of games played concurrently by the selfplay command. */
+    unsigned m_selfplay_games = 1;
+
+    /** Number of search threads per concurrent selfplay game.
+        0 means to split the threads of the player evenly. */
+    unsigned m_selfplay_threads = 0;
+
     void create_player(Variant variant, unsigned level,
                        const string& books_dir, unsigned nu_threads);
 
@@ -16,6 +16,7 @@ using libboardgame_base::RandomGenerator;
 using libboardgame_gtp::Failure;
 using libpentobi_base::parse_variant_id;
 using libpentobi_base::Board;
+using libpentobi_base::BoardConst;
 using libpentobi_base::Variant;
 using libpentobi_mcts::Player;
 
@@ -50,6 +51,7 @@ int main(int argc, char** argv)
     {
         vector<string> specs = {
             "book:",
+            "cache:",
             "config|c:",
             "color",
             "cputime",
@@ -58,6 +60,7 @@ int main(int argc, char** argv)
             "level|l:",
             "nobook",
             "noresign",
+            "ponder",
             "quiet|q",
             "seed|r:",
             "showboard",
@@ -70,6 +73,7 @@ int main(int argc, char** argv)
             cout <<
                 "Usage: pentobi_gtp [options] [input files]\n"
                 "--book       load an external book file\n"
+                "--cache      directory for caching precomputed move tables\n"
                 "--config,-c  set GTP config file\n"
                 "--color      colorize text output of boards\n"
                 "--cputime    use CPU time\n"
@@ -82,6 +86,7 @@ int main(int argc, char** argv)
                 "             changes\n"
                 "--nobook     disable opening book\n"
                 "--noresign   disable resign\n"
+                "--ponder     think while waiting for the next command\n"
                 "--quiet,-q   do not print logging messages\n"
                 "--threads    number of threads in the search\n"
                 "--version,-v print version and exit\n";
@@ -104,6 +109,7 @@ int main(int argc, char** argv)
                 throw runtime_error("Number of threads must be greater zero.");
         }
         Board::color_output = opt.contains("color");
+        BoardConst::set_cache_dir(opt.get("cache", ""));
         if (opt.contains("quiet"))
             libboardgame_base::disable_logging();
         if (opt.contains("seed"))
@@ -120,6 +126,8 @@ int main(int argc, char** argv)
         const string& books_dir = application_dir_path;
         GtpEngine engine(variant, level, use_book, books_dir, threads);
         engine.set_resign(! opt.contains("noresign"));
+        if (opt.contains("ponder"))
+            engine.set_ponder(true);
         if (opt.contains("showboard"))
             engine.set_show_board(true);
         if (opt.contains("cputime"))